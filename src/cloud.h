@@ -2,6 +2,9 @@
 
 #include <vector>
 #include <list>
+#include <set>
+#include <array>
+#include <algorithm>
 
 #include "shape.h"
 #include "bitmap.h"
@@ -46,6 +49,7 @@ public:
 	using xform_t = typename grid::xform_t;
 	using point_t = typename grid::point_t;
 	using bitgrid_t = bitgrid<128>;
+	using tuplegrid_t = bitgrid<128,2>;
 
 	Cloud( const Shape<grid>& shape, Orientations ori = ALL, bool reduce = false );
 
@@ -57,6 +61,10 @@ public:
 	{
 		return adjacent_.find( T ) != adjacent_.end();
 	}
+	bool isAdjacentUnreduced( const xform_t& T ) const
+	{
+		return adjacent_unreduced_.find( T ) != adjacent_unreduced_.end();
+	}
 	bool isHoleAdjacent( const xform_t& T ) const
 	{
 		return adjacent_hole_.find( T ) != adjacent_hole_.end();
@@ -74,6 +82,12 @@ public:
 	bool checkSimplyConnected( bitgrid_t& bits, const xform_t& T );
 	bool checkSimplyConnectedOld( const xform_t& T );
 	void reduceAdjacents();
+	void findHoleTuples( size_t max_size );
+	bool enclosesHole( tuplegrid_t& bits, const std::vector<xform_t>& Ts ) const;
+	void placeCopies( tuplegrid_t& bits, 
+		const std::vector<xform_t>& Ts, size_t skip ) const;
+	bool smallRegion( tuplegrid_t& bits, const point_t& p,
+		std::vector<point_t>& region ) const;
 
 	void debug( std::ostream& os ) const;
 	void debugTransform( std::ostream& os, const xform_t& T ) const;
@@ -89,6 +103,11 @@ public:
 	xform_set<coord_t> adjacent_hole_;
 	xform_set<coord_t> overlapping_;
 	bool surroundable_;
+
+	// Sets of placements that enclose a hole together with the shape 
+	// itself, found by findHoleTuples().  Each set is filed under one of
+	// its members that's adjacent to the shape, and lists the others.
+	xform_map<coord_t,std::vector<std::vector<xform_t>>> hole_tuples_;
 };
 
 template<typename grid>
@@ -99,6 +118,7 @@ Cloud<grid>::Cloud( const Shape<grid>& shape, Orientations ori, bool reduce )
 	, adjacent_hole_ {}
 	, overlapping_ {}
 	, surroundable_ { true }
+	, hole_tuples_ {}
 {
 	shape.getHaloAndBorder( halo_, border_ );
 	calcOrientations( ori );
@@ -370,6 +390,230 @@ void Cloud<grid>::reduceAdjacents()
 	adjacent_ = std::move( cur_adj );
 }
 
+// Find sets of two or three placements that, together with the shape,
+// enclose a hole too small to hold another copy, and that all touch the
+// hole.  Those copies can't all be used in the outer corona of a 
+// hole-free patch.  The search stays close to the shape: every placement 
+// is adjacent to it, and at most max_size copies are involved in all.
+// Sets that include a hole-adjacent pair or a smaller set are left out,
+// because they're ruled out already.
+template<typename grid>
+void Cloud<grid>::findHoleTuples( size_t max_size )
+{
+	hole_tuples_.clear();
+	if( !surroundable_ || (max_size < 3) ) {
+		return;
+	}
+
+	std::vector<xform_t> adj { 
+		adjacent_unreduced_.begin(), adjacent_unreduced_.end() };
+	size_t num = adj.size();
+
+	// How each pair of placements relates to each other.
+	enum Relation : uint8_t { CLASH, ADJACENT, APART };
+	std::vector<Relation> rel( num * num, CLASH );
+	for( size_t i = 0; i < num; ++i ) {
+		xform_t Ti = adj[i].invert();
+		for( size_t j = i + 1; j < num; ++j ) {
+			xform_t M = Ti * adj[j];
+			Relation r = CLASH;
+			if( isAdjacentUnreduced( M ) ) {
+				r = ADJACENT;
+			} else if( !M.isIdentity() && !isAny( M ) ) {
+				r = APART;
+			}
+			rel[i * num + j] = r;
+			rel[j * num + i] = r;
+		}
+	}
+
+	tuplegrid_t bits;
+	std::vector<xform_t> Ts { xform_t {} };
+
+	// Three copies enclosing a hole must all be adjacent to each other.
+	std::vector<bool> triple( num * num, false );
+	for( size_t i = 0; i < num; ++i ) {
+		for( size_t j = i + 1; j < num; ++j ) {
+			if( rel[i * num + j] != ADJACENT ) {
+				continue;
+			}
+			Ts.resize( 1 );
+			Ts.push_back( adj[i] );
+			Ts.push_back( adj[j] );
+			if( enclosesHole( bits, Ts ) ) {
+				triple[i * num + j] = true;
+				triple[j * num + i] = true;
+				hole_tuples_[adj[i]].push_back( { adj[j] } );
+			}
+		}
+	}
+
+	if( max_size < 4 ) {
+		return;
+	}
+
+	// Four copies around a hole form a ring, in which the shape's two
+	// neighbours, i and j, are both adjacent to the copy opposite it, 
+	// which is either adjacent to the shape too or else two steps away.
+	std::set<std::array<size_t,3>> seen;
+	xform_map<coord_t,size_t> index;
+	for( size_t i = 0; i < num; ++i ) {
+		index[adj[i]] = i;
+	}
+
+	for( size_t i = 0; i < num; ++i ) {
+		for( size_t j = i + 1; j < num; ++j ) {
+			if( (rel[i * num + j] == CLASH) || triple[i * num + j] ) {
+				continue;
+			}
+			xform_t Tj = adj[j].invert();
+
+			for( const auto& X : adj ) {
+				xform_t Tk = adj[i] * X;
+				if( Tk.isIdentity() || isOverlap( Tk ) || isHoleAdjacent( Tk )
+						|| !isAdjacentUnreduced( Tj * Tk ) ) {
+					continue;
+				}
+
+				auto ki = index.find( Tk );
+				if( ki != index.end() ) {
+					size_t k = ki->second;
+					if( triple[i * num + k] || triple[j * num + k] ) {
+						continue;
+					}
+					std::array<size_t,3> key { i, j, k };
+					std::sort( key.begin(), key.end() );
+					if( !seen.insert( key ).second ) {
+						continue;
+					}
+				}
+
+				Ts.resize( 1 );
+				Ts.push_back( adj[i] );
+				Ts.push_back( adj[j] );
+				Ts.push_back( Tk );
+				if( enclosesHole( bits, Ts ) ) {
+					hole_tuples_[adj[i]].push_back( { adj[j], Tk } );
+				}
+			}
+		}
+	}
+}
+
+// Mark the cells of the copies at Ts, other than Ts[skip], as covered
+// (1) and all others as empty (0).
+template<typename grid>
+void Cloud<grid>::placeCopies( tuplegrid_t& bits, 
+	const std::vector<xform_t>& Ts, size_t skip ) const
+{
+	bits.clear();
+	for( size_t idx = 0; idx < Ts.size(); ++idx ) {
+		if( idx != skip ) {
+			for( const auto& p : shape_ ) {
+				bits.set( Ts[idx] * p, 1 );
+			}
+		}
+	}
+}
+
+// Flood the empty cells connected to p, marking them as visited (2), 
+// and giving up once there are enough of them to hold a copy.  Return
+// true if there aren't.  A region that's given up on is marked as large
+// (3), so that a later flood that runs into it knows it's in the same 
+// region, and doesn't mistake the cells already visited for a wall.
+template<typename grid>
+bool Cloud<grid>::smallRegion( tuplegrid_t& bits, const point_t& p, 
+	std::vector<point_t>& region ) const
+{
+	size_t sz = shape_.size();
+	region.clear();
+	region.push_back( p );
+	bits.set( p, 2 );
+
+	bool large = false;
+	for( size_t idx = 0; !large && (idx < region.size()); ++idx ) {
+		for( auto pn : edge_neighbours<grid> { region[idx] } ) {
+			uint8_t v = bits.get( pn );
+			if( v == 0 ) {
+				bits.set( pn, 2 );
+				region.push_back( pn );
+			} else if( v == 3 ) {
+				large = true;
+			}
+		}
+		if( region.size() >= sz ) {
+			large = true;
+		}
+	}
+
+	if( large ) {
+		for( const auto& q : region ) {
+			bits.set( q, 3 );
+		}
+	}
+	return !large;
+}
+
+// Check whether the copies at Ts enclose a region of empty cells that's
+// too small to hold another copy, and need all of them to do it.
+template<typename grid>
+bool Cloud<grid>::enclosesHole( 
+	tuplegrid_t& bits, const std::vector<xform_t>& Ts ) const
+{
+	std::vector<point_t> region;
+	std::vector<point_t> holes;
+	point_set<coord_t> around;
+
+	placeCopies( bits, Ts, Ts.size() );
+	for( const auto& T : Ts ) {
+		for( const auto& h : halo_ ) {
+			point_t p = T * h;
+			if( (bits.get( p ) != 0) || !smallRegion( bits, p, region ) ) {
+				continue;
+			}
+
+			// Every copy must touch the region.
+			around.clear();
+			for( const auto& q : region ) {
+				for( auto pn : neighbours<grid> { q } ) {
+					around.insert( pn );
+				}
+			}
+			bool all = true;
+			for( const auto& S : Ts ) {
+				bool touches = false;
+				for( const auto& q : shape_ ) {
+					if( around.find( S * q ) != around.end() ) {
+						touches = true;
+						break;
+					}
+				}
+				if( !touches ) {
+					all = false;
+					break;
+				}
+			}
+			if( all ) {
+				holes.push_back( p );
+			}
+		}
+	}
+
+	// And none of them can be left out.
+	for( const auto& p : holes ) {
+		bool needed = true;
+		for( size_t skip = 0; needed && (skip < Ts.size()); ++skip ) {
+			placeCopies( bits, Ts, skip );
+			needed = !smallRegion( bits, p, region );
+		}
+		if( needed ) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 template<typename grid>
 void Cloud<grid>::calcOrientations( Orientations ori )
 {
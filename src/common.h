@@ -1,5 +1,8 @@
 #pragma once
 
+#include <iostream>
+#include <cstdlib>
+
 template<typename T>
 struct method_hash
 {
@@ -65,3 +68,16 @@ inline char gridTypeAbbreviation( GridType gt )
 		default: return '?';
 	}
 }
+
+// Step past a command-line option to its value, exiting with a message
+// if the option comes last and has none.
+inline const char *optionValue( int argc, char **argv, int& idx )
+{
+	if( idx + 1 >= argc ) {
+		std::cerr << "Missing value for \"" << argv[idx] << "\"" 
+			<< std::endl;
+		exit( 0 );
+	}
+	++idx;
+	return argv[idx];
+}
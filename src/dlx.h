@@ -0,0 +1,302 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "heesch.h"
+#include "cloud.h"
+#include "holes.h"
+
+// Enumerate the hole-free 1-coronas of a shape as an exact cover problem,
+// using Knuth's dancing links (Algorithm X).  The rows are the placements
+// in the cloud's adjacent_ set, the same ones HeeschSolver offers at level
+// 1.  The kernel's halo cells are primary columns, which must be covered
+// exactly once; every other cell a row covers is a secondary column,
+// covered at most once, which rules out overlaps.  Each pair of rows
+// that are hole-adjacent to each other also shares a secondary column of
+// its own, so that they can't be used together.  Any holes that remain
+// are found at the leaves.  This finds the same coronas as
+// HeeschSolver::allCoronas() at level 1, without a SAT solver, and
+// without a clause for each corona found.
+template<typename grid>
+class SurroundDLX
+{
+public:
+	using coord_t = typename grid::coord_t;
+	using point_t = typename grid::point_t;
+	using xform_t = typename grid::xform_t;
+
+	SurroundDLX( const Shape<grid>& shape, const Cloud<grid>& cloud );
+	// finder_ refers to shape_, so a copy would refer to the original's.
+	SurroundDLX( const SurroundDLX& ) = delete;
+	SurroundDLX& operator =( const SurroundDLX& ) = delete;
+
+	// The callbacks follow the conventions of HeeschSolver::allCoronas()
+	// and countCoronas().  Both return the number of coronas found.
+	size_t allCoronas( solution_cb<coord_t> cb );
+	size_t countCoronas( count_cb cb );
+
+private:
+	using node_t = uint32_t;
+
+	static std::vector<point_t> allCells( 
+		const Shape<grid>& shape, const Cloud<grid>& cloud );
+	void addColumn( bool primary );
+	void cover( node_t c );
+	void uncover( node_t c );
+	bool search();
+
+	Shape<grid> shape_;
+	std::vector<xform_t> rows_;
+
+	// The nodes of the matrix.  Node 0 is the root, nodes 1 to the number
+	// of columns are the column headers, and the rest belong to rows,
+	// each row's nodes stored together.
+	std::vector<node_t> left_;
+	std::vector<node_t> right_;
+	std::vector<node_t> up_;
+	std::vector<node_t> down_;
+	std::vector<node_t> col_;
+	std::vector<size_t> row_of_;
+	std::vector<size_t> size_;
+
+	// The search in progress.  Copy 0 of the hole finder is the kernel,
+	// and row r is copy r + 1.
+	HoleFinder<grid> finder_;
+	std::vector<size_t> chosen_;
+	std::vector<std::vector<tile_index>> holes_;
+	std::function<bool()> report_;
+	size_t found_;
+};
+
+// The cells of the kernel and of every row.
+template<typename grid>
+std::vector<typename grid::point_t> SurroundDLX<grid>::allCells(
+	const Shape<grid>& shape, const Cloud<grid>& cloud )
+{
+	std::vector<point_t> cells { shape.begin(), shape.end() };
+	for( const auto& T : cloud.adjacent_ ) {
+		for( const auto& p : shape ) {
+			cells.push_back( T * p );
+		}
+	}
+	return cells;
+}
+
+template<typename grid>
+SurroundDLX<grid>::SurroundDLX(
+		const Shape<grid>& shape, const Cloud<grid>& cloud )
+	: shape_ { shape }
+	, rows_ {}
+	, left_ {}
+	, right_ {}
+	, up_ {}
+	, down_ {}
+	, col_ {}
+	, row_of_ {}
+	, size_ {}
+	, finder_ { shape_, allCells( shape_, cloud ) }
+	, chosen_ {}
+	, holes_ {}
+	, report_ {}
+	, found_ { 0 }
+{
+	finder_.addCopy( 0, grid::orientations[0] );
+
+	// The root.
+	addColumn( false );
+	if( !cloud.surroundable_ ) {
+		return;
+	}
+	rows_.assign( cloud.adjacent_.begin(), cloud.adjacent_.end() );
+
+	// The halo cells, as primary columns.
+	point_map<coord_t,node_t> cols;
+	for( const auto& p : cloud.halo_ ) {
+		cols[p] = col_.size();
+		addColumn( true );
+	}
+
+	// Secondary columns for the other cells of the rows.
+	std::vector<std::vector<node_t>> row_cols( rows_.size() );
+	for( size_t r = 0; r < rows_.size(); ++r ) {
+		for( const auto& p : shape_ ) {
+			point_t q = rows_[r] * p;
+			auto i = cols.find( q );
+			if( i == cols.end() ) {
+				i = cols.emplace( q, col_.size() ).first;
+				addColumn( false );
+			}
+			row_cols[r].push_back( i->second );
+		}
+	}
+
+	// And one for every hole-adjacent pair of rows, visited from its
+	// first row.
+	for( size_t r = 0; r < rows_.size(); ++r ) {
+		xform_t Ti = rows_[r].invert();
+		for( size_t s = r + 1; s < rows_.size(); ++s ) {
+			if( cloud.isHoleAdjacent( Ti * rows_[s] ) ) {
+				row_cols[r].push_back( col_.size() );
+				row_cols[s].push_back( col_.size() );
+				addColumn( false );
+			}
+		}
+	}
+
+	// Now the row nodes, each appended at the bottom of its column.
+	for( size_t r = 0; r < rows_.size(); ++r ) {
+		node_t first = col_.size();
+		for( auto c : row_cols[r] ) {
+			node_t n = col_.size();
+			node_t prev = (n == first) ? n : n - 1;
+			node_t above = up_[c];
+
+			col_.push_back( c );
+			row_of_.push_back( r );
+			left_.push_back( prev );
+			right_.push_back( first );
+			right_[prev] = n;
+			left_[first] = n;
+
+			up_.push_back( above );
+			down_.push_back( c );
+			down_[above] = n;
+			up_[c] = n;
+			++size_[c];
+		}
+	}
+}
+
+// Append a column header.  Primary columns are linked into the list of
+// columns still to be covered, just before the root; secondary columns
+// are left on their own.
+template<typename grid>
+void SurroundDLX<grid>::addColumn( bool primary )
+{
+	node_t c = col_.size();
+	col_.push_back( c );
+	row_of_.push_back( 0 );
+	size_.push_back( 0 );
+	up_.push_back( c );
+	down_.push_back( c );
+	if( primary ) {
+		node_t last = left_[0];
+		left_.push_back( last );
+		right_.push_back( 0 );
+		right_[last] = c;
+		left_[0] = c;
+	} else {
+		left_.push_back( c );
+		right_.push_back( c );
+	}
+}
+
+template<typename grid>
+void SurroundDLX<grid>::cover( node_t c )
+{
+	right_[left_[c]] = right_[c];
+	left_[right_[c]] = left_[c];
+	for( node_t i = down_[c]; i != c; i = down_[i] ) {
+		for( node_t j = right_[i]; j != i; j = right_[j] ) {
+			down_[up_[j]] = down_[j];
+			up_[down_[j]] = up_[j];
+			--size_[col_[j]];
+		}
+	}
+}
+
+template<typename grid>
+void SurroundDLX<grid>::uncover( node_t c )
+{
+	for( node_t i = up_[c]; i != c; i = up_[i] ) {
+		for( node_t j = left_[i]; j != i; j = left_[j] ) {
+			++size_[col_[j]];
+			down_[up_[j]] = j;
+			up_[down_[j]] = j;
+		}
+	}
+	right_[left_[c]] = c;
+	left_[right_[c]] = c;
+}
+
+// Return false once the search should stop.
+template<typename grid>
+bool SurroundDLX<grid>::search()
+{
+	if( right_[0] == 0 ) {
+		// Every halo cell is covered.
+		if( !finder_.getHoles( holes_ ) ) {
+			++found_;
+			return report_();
+		}
+		return true;
+	}
+
+	// Branch on the halo cell with the fewest rows left.
+	node_t c = right_[0];
+	for( node_t j = right_[c]; j != 0; j = right_[j] ) {
+		if( size_[j] < size_[c] ) {
+			c = j;
+		}
+	}
+	if( size_[c] == 0 ) {
+		return true;
+	}
+
+	bool more = true;
+	cover( c );
+	for( node_t r = down_[c]; more && (r != c); r = down_[r] ) {
+		size_t row = row_of_[r];
+		for( node_t j = right_[r]; j != r; j = right_[j] ) {
+			cover( col_[j] );
+		}
+		chosen_.push_back( row );
+		finder_.addCopy( row + 1, rows_[row] );
+
+		more = search();
+
+		finder_.removeCopy( row + 1, rows_[row] );
+		chosen_.pop_back();
+		for( node_t j = left_[r]; j != r; j = left_[j] ) {
+			uncover( col_[j] );
+		}
+	}
+	uncover( c );
+
+	return more;
+}
+
+template<typename grid>
+size_t SurroundDLX<grid>::allCoronas( solution_cb<coord_t> cb )
+{
+	Solution<coord_t> soln;
+	report_ = [this, &cb, &soln]() {
+		soln.clear();
+		soln.emplace_back( 0, grid::orientations[0] );
+		for( auto row : chosen_ ) {
+			soln.emplace_back( 1, rows_[row] );
+		}
+		return cb( soln );
+	};
+
+	found_ = 0;
+	if( !rows_.empty() ) {
+		search();
+	}
+	return found_;
+}
+
+template<typename grid>
+size_t SurroundDLX<grid>::countCoronas( count_cb cb )
+{
+	report_ = [this, &cb]() {
+		return cb( chosen_.size() + 1 );
+	};
+
+	found_ = 0;
+	if( !rows_.empty() ) {
+		search();
+	}
+	return found_;
+}
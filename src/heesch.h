@@ -1,21 +1,28 @@
 #pragma once
 
 #include <vector>
-#include <list>
-#include <map>
+#include <set>
+#include <limits>
+#include <algorithm>
+#include <memory>
 #include <functional>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
-#include <cryptominisat.h>
+#include "satbackend.h"
 
 #include "cloud.h"
 #include "holes.h"
+#include "holeprop.h"
 
 // The core of the whole system: a class that understands how to compute
 // Heesch numbers of polyforms.  As of 2023, also includes the ability
 // to check whether a polyform tiles isohedrally.
 
-using var_id = uint32_t;
-
 template<typename coord_t>
 using Solution = std::vector<std::pair<size_t,xform<coord_t>>>;
 
@@ -24,47 +31,27 @@ using Solution = std::vector<std::pair<size_t,xform<coord_t>>>;
 template<typename coord_t>
 using solution_cb = std::function<bool( const Solution<coord_t>& )>;
 
-template<typename grid>
-struct tile_info
-{
-	using xform_t = typename grid::xform_t;
-
-	tile_info( const xform_t& T, tile_index index )
-		: T_ { T }
-		, index_ { index }
-		, vars_ {}
-		, cells_ {}
-	{}
-
-	bool hasLevel( size_t level ) const
-	{
-		return vars_.find( level ) != vars_.end();
-	}
-
-	xform_t T_;
-	tile_index index_;
-
-	// The SAT variable used at each corona level accessible at this location.
-	std::map<size_t,var_id> vars_;
-	std::list<cell_index> cells_;
-};
-
-template<typename grid>
-struct cell_info
+// Like solution_cb, but given only the number of tiles in a solution,
+// kernel included, for clients that just count them.
+using count_cb = std::function<bool( size_t )>;
+
+// Marks an empty slot in a tile's table of per-level variables.
+constexpr var_id NO_VAR = std::numeric_limits<var_id>::max();
+// Marks a tile whose halo cells haven't been looked up.
+constexpr uint32_t NO_HALO = std::numeric_limits<uint32_t>::max();
+// The conflicts allowed for a warm-started attempt before it gives up
+// on the soft assumptions.
+constexpr uint64_t WARM_CONFLICTS = 10000;
+
+// How the corona levels of each tile placement are encoded.  With
+// DIRECT_LEVELS, the variable for level k means "this placement is used
+// in the k-corona".  With LADDER_LEVELS (an order encoding), it means
+// "this placement is used in the j-corona for some j <= k", so that the
+// variables of a placement form an increasing chain.
+enum LevelEncoding
 {
-	using point_t = typename grid::point_t;
-
-	cell_info( const point_t& p, cell_index index )
-		: pos_ { p }
-		, index_ { index }
-		, tiles_ {}
-	{}
-
-	point_t pos_;
-	cell_index index_;
-	var_id var_;
-
-	std::list<tile_index> tiles_;
+	DIRECT_LEVELS,
+	LADDER_LEVELS
 };
 
 template<typename grid>
@@ -75,7 +62,8 @@ public:
 	using point_t = typename grid::point_t;
 	using xform_t = typename grid::xform_t;
 
-	HeeschSolver( const Shape<grid>& shape, Orientations ori = ALL, bool reduce = true );
+	HeeschSolver( const Shape<grid>& shape, Orientations ori = ALL, 
+		bool reduce = true, LevelEncoding enc = DIRECT_LEVELS );
 
 	void increaseLevel();
 	size_t getLevel() const
@@ -89,6 +77,115 @@ public:
 	void setCheckHoleCoronas( bool b )
 	{ 
 		check_hh_ = b;
+		if( b && (hole_sel_ == 0) ) {
+			hole_sel_ = declareVariable();
+		}
+	}
+
+	// In incremental mode, a single SAT solver is kept alive across
+	// all corona levels, so that learned clauses carry over from one
+	// level to the next.
+	void setIncremental( bool b )
+	{
+		incremental_ = b;
+	}
+
+	// Encode non-overlap with an at-most-one constraint on the tiles
+	// covering each cell (a sequential counter with one register per
+	// tile and cell), instead of a binary clause for every pair of 
+	// variables of overlapping tiles.
+	void setCellAtMostOne( bool b )
+	{
+		cell_amo_ = b;
+		if( b ) {
+			addCellRegisters();
+		}
+	}
+
+	// Add lex-leader symmetry-breaking clauses for the symmetries of the
+	// kernel, so that hasCorona() doesn't explore every symmetric image
+	// of a corona.  They're switched on by a selector variable that only
+	// hasCorona() assumes, so enumeration of coronas is unaffected.
+	void setSymmetryBreaking( bool b );
+
+	// Start the search at each level from the hole-free corona found at
+	// the previous one, whose tiles usually survive as the inner coronas.
+	// Those tiles are suggested to the solver as phases, and assumed in
+	// a first attempt, which is repeated without them if it fails.
+	void setWarmStart( bool b )
+	{
+		warm_start_ = b;
+	}
+
+	// Look for holes in the outer corona during search, with a 
+	// HolePropagator, when the backend supports it.  The hole-finding
+	// loop still checks every model, so this only saves iterations.
+	void setHolePropagation( bool b )
+	{
+		hole_propagation_ = b;
+	}
+
+	// Rule out, up front, sets of up to max_size copies in the outer
+	// corona that enclose a hole too small for another copy, instead of
+	// waiting for the hole-finding loop to stumble on them (see
+	// Cloud::findHoleTuples()).  Must be called before increaseLevel().
+	void setHoleTuples( size_t max_size )
+	{
+		cloud_.findHoleTuples( max_size );
+	}
+
+	// Use the named SAT backend (see satbackend.h) for all solving.
+	void setBackend( const std::string& name )
+	{
+		backend_ = name;
+	}
+
+	// Race size differently seeded instances of the backend in separate
+	// threads when looking for a corona, once the problem has more than
+	// clause_limit clauses or a single instance has spent time_limit
+	// seconds on it (see PortfolioBackend).  A size of 1 disables this.
+	void setPortfolio( size_t size, size_t clause_limit, double time_limit )
+	{
+		portfolio_size_ = size;
+		portfolio_clauses_ = clause_limit;
+		portfolio_time_ = time_limit;
+	}
+
+	// Look for each corona by cube and conquer: split the problem into
+	// cubes by the choice of level-1 tiles covering the first depth cells 
+	// of the kernel's halo, and solve the cubes on a pool of threads 
+	// until one yields a hole-free corona.  Each level is then solved 
+	// from scratch, even in incremental mode.  allCoronas() and
+	// countCoronas() split their enumeration the same way, and call
+	// back from the worker threads one at a time, in no particular 
+	// order.  Zero threads disables this.
+	void setCubeAndConquer( size_t threads, size_t depth )
+	{
+		cube_threads_ = threads;
+		cube_depth_ = depth;
+	}
+
+	// Limits on the effort spent solving: seconds_per_shape covers every
+	// query from this call onwards, while the other two apply to each
+	// query to the SAT solver separately.  Zero means no limit.  Once a
+	// limit is hit, hasCorona() returns false and timedOut() is true.
+	void setBudget( double seconds_per_shape, double seconds_per_call,
+		uint64_t conflicts_per_call )
+	{
+		shape_seconds_ = seconds_per_shape;
+		call_seconds_ = seconds_per_call;
+		call_conflicts_ = conflicts_per_call;
+		start_time_ = std::chrono::steady_clock::now();
+	}
+
+	// Write every corona problem given to the SAT solver to a file in
+	// DIMACS format, named prefix_<level>.cnf (prefix_<level>h.cnf if
+	// holes are allowed in the outer corona, prefix_<level>all.cnf for
+	// allCoronas()), with the assumptions as unit clauses.  A sidecar
+	// .map file relates the variables to tiles and cells.
+	void setDumpCNF( const std::string& prefix )
+	{
+		dump_prefix_ = prefix;
 	}
 
 	bool tilesIsohedrally() const
@@ -96,10 +193,26 @@ public:
 		return tiles_isohedrally_;
 	}
 
+	bool timedOut() const
+	{
+		return timed_out_;
+	}
+
+	bool isSurroundable() const
+	{
+		return cloud_.surroundable_;
+	}
+
 	bool hasCorona( 
 		bool get_solution, bool& has_holes, Solution<coord_t>& soln );
+	// Decide isohedral tiling on its own, from the clauses for a 
+	// hole-free 1-corona, without looking for coronas first.  Call
+	// at level 1.
+	bool checkIsohedral();
 	void allCoronas( std::vector<Solution<coord_t>>& solns );
 	void allCoronas( solution_cb<coord_t> cb ) const;
+	// Like allCoronas(), but without building the coronas.
+	void countCoronas( count_cb cb ) const;
 
 	void debug( std::ostream& os ) const;
 
@@ -108,6 +221,9 @@ private:
 	tile_index getTile( const xform_t& T ) const;
 	cell_index getCell( const point_t& p, bool create );
 	tile_index createNewTile( const xform_t& T );
+	void linkNeighbours( tile_index tidx, const xform_set<coord_t>& Ms,
+		std::vector<std::vector<tile_index>>& nbrs );
+	void findHalo( tile_index tidx );
 
 	var_id getShapeVariable( const xform_t& T, size_t level );
 	bool getShapeVariable( const xform_t& T, size_t level, var_id& id ) const;
@@ -115,31 +231,195 @@ private:
 	var_id getCellVariable( const point_t& p );
 	var_id getCellVariable( const point_t& p ) const;
 
-	void getClauses( CMSat::SATSolver& solv, bool allow_holes ) const;
+	size_t numTiles() const
+	{
+		return tile_xforms_.size();
+	}
+	var_id tileVar( tile_index tidx, size_t level ) const
+	{
+		return (level < var_stride_) 
+			? tile_vars_[tidx * var_stride_ + level] : NO_VAR;
+	}
+	// The variable of the tile's highest level that doesn't exceed 
+	// level, or NO_VAR.  In the ladder encoding, this is the variable
+	// that means "used at a level <= level".
+	var_id levelAtMost( tile_index tidx, size_t level ) const
+	{
+		for( size_t k = std::min( level + 1, var_stride_ ); k > 0; --k ) {
+			var_id v = tile_vars_[tidx * var_stride_ + k - 1];
+			if( v != NO_VAR ) {
+				return v;
+			}
+		}
+		return NO_VAR;
+	}
+	// Whether the tile is used at any level in the solver's model.
+	bool tileUsed( const SATBackend& solv, tile_index tidx ) const
+	{
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			if( (vars[k] != NO_VAR) && solv.value( vars[k] ) ) {
+				return true;
+			}
+		}
+		return false;
+	}
+	void excludeLevel( 
+		tile_index tidx, size_t level, std::vector<sat_lit>& cl ) const;
+	void widenVarTable( size_t width );
+	void indexCells();
+	void addCellRegisters();
+	void updateSymmetries();
+	void getSymmetryClauses( SATBackend& solv, 
+		const std::vector<sat_lit>& guard ) const;
+	void getHoleTupleClauses( SATBackend& solv, 
+		const std::vector<sat_lit>& guard ) const;
+
+	void getClauses( SATBackend& solv, bool allow_holes,
+		const std::vector<sat_lit>& guard = {}, 
+		var_id from_var = 0, size_t from_level = 0 ) const;
+	void getLadderClauses( SATBackend& solv, bool allow_holes,
+		const std::vector<sat_lit>& guard, 
+		var_id from_var, size_t from_level ) const;
+	SATBackend& getIncrementalSolver( var_id& act );
+	std::unique_ptr<SATBackend> makeSolver() const;
+	bool applyBudget( SATBackend& solv ) const;
+	SATResult solveWithinBudget( 
+		SATBackend& solv, const std::vector<sat_lit>& assumps );
+	SATResult solveWarm( SATBackend& solv, 
+		const std::vector<sat_lit>& assumps, std::vector<sat_lit>& soft );
+	void recordWarmStart( const SATBackend& solv );
+	std::unique_ptr<HolePropagator<grid>> makeHolePropagator(
+		const std::vector<sat_lit>& guard ) const;
+	bool getHoleClauses( const SATBackend& solv, 
+		const std::vector<sat_lit>& guard, HoleFinder<grid>& finder,
+		std::vector<std::vector<sat_lit>>& cls ) const;
+	bool hasHoleCorona( bool get_solution, bool& has_holes, 
+		Solution<coord_t>& soln );
+	void getCubes( std::vector<std::vector<sat_lit>>& cubes ) const;
+	SATResult solveCubes( bool get_solution, bool& has_holes, 
+		Solution<coord_t>& soln );
+	void dumpCNF( const SATBackend& solv, const std::vector<sat_lit>& assumps,
+		const std::string& suffix ) const;
 	void getSolution(
-		const CMSat::SATSolver& solv, Solution<coord_t>& ret ) const;
+		const SATBackend& solv, Solution<coord_t>& ret ) const;
 	void addHolesToLevel();
 	void extendLevelWithTransforms( size_t lev, const xform_set<coord_t>& Ts );
 
-	size_t allCoronas( CMSat::SATSolver& solv, solution_cb<coord_t> cb ) const;
-	// bool checkIsohedralTiling_deprecated( CMSat::SATSolver& solv );
-	bool checkIsohedralTiling( CMSat::SATSolver& solv );
+	size_t allCoronas( SATBackend& solv, solution_cb<coord_t> cb,
+		const std::vector<sat_lit>& assumps = {}, 
+		bool *interrupted = nullptr ) const;
+	// Called with the solver holding each corona and its number of tiles.
+	using corona_cb = std::function<bool( const SATBackend&, size_t )>;
+	size_t enumerateCoronas( SATBackend& solv, const corona_cb& cb,
+		const std::vector<sat_lit>& assumps, bool *interrupted ) const;
+	void enumerateCoronas( const corona_cb& cb ) const;
+	void enumerateCubes( const corona_cb& cb ) const;
+	// bool checkIsohedralTiling_deprecated( SATBackend& solv );
+	bool checkIsohedralTiling( SATBackend& solv, 
+		const std::vector<sat_lit>& assumps = {} );
 	// bool isSurroundIsohedral( const Solution<coord_t>& soln ) const;
 
 	Shape<grid> shape_;
 	Cloud<grid> cloud_;
-
-	std::vector<tile_info<grid>> tiles_;
-	std::vector<cell_info<grid>> cells_;
+	LevelEncoding encoding_;
+
+	// Tiles and cells are stored as parallel arrays indexed by 
+	// tile_index and cell_index.  Each tile has a fixed-width row of
+	// var_stride_ entries in tile_vars_, giving its SAT variable at 
+	// each level (or NO_VAR), and a row of shape_.size() entries in
+	// tile_cells_, giving the cells it covers.
+	std::vector<xform_t> tile_xforms_;
+	std::vector<var_id> tile_vars_;
+	std::vector<cell_index> tile_cells_;
+	size_t var_stride_;
+
+	std::vector<point_t> cell_pos_;
+	std::vector<var_id> cell_vars_;
+	// The tiles covering each cell, in compressed form: the tiles over
+	// cell i are cell_tiles_[cell_start_[i]] to cell_tiles_[cell_start_[i+1]-1].
+	// Rebuilt by indexCells() whenever new tiles have been created.
+	std::vector<uint32_t> cell_start_;
+	std::vector<tile_index> cell_tiles_;
+	// In at-most-one mode, the counter register for each entry of 
+	// tile_cells_, which is true if this tile or one created before it
+	// covers that cell.
+	std::vector<var_id> cell_regs_;
+
+	// The tiles that overlap, are adjacent to, or are adjacent with holes
+	// to each tile.  Linked in both directions when a tile is created, so
+	// that clause generation never has to search for neighbours.
+	std::vector<std::vector<tile_index>> tile_overlaps_;
+	std::vector<std::vector<tile_index>> tile_adjacents_;
+	std::vector<std::vector<tile_index>> tile_hole_adjacents_;
+
+	// The halo cells of each tile that has been used in an interior
+	// corona, found when that corona was completed.  The halo of tile t
+	// is cloud_.halo_.size() entries starting at halo_cells_[tile_halo_[t]].
+	std::vector<uint32_t> tile_halo_;
+	std::vector<cell_index> halo_cells_;
 
 	xform_map<coord_t,tile_index> tile_map_;
 	point_map<coord_t,cell_index> cell_map_;
 
+	// The tiles that have a variable at each level.
+	std::vector<std::vector<tile_index>> level_tiles_;
+	// The tiles that gained variables since the last encoding, which 
+	// covered all variables below encoded_var_.  In incremental mode,
+	// it had encoded_level_ as its outer level.
+	std::vector<tile_index> fresh_tiles_;
+	var_id encoded_var_;
+	size_t encoded_level_;
+
 	size_t level_;
 	var_id next_var_;
 	bool check_isohedral_;
 	bool check_hh_;
-	bool tiles_isohedrally_;;
+	bool incremental_;
+	bool cell_amo_;
+	bool break_symmetry_;
+	bool warm_start_;
+	bool hole_propagation_;
+	// The tiles of the last hole-free corona found, as literals.
+	std::vector<sat_lit> warm_lits_;
+	std::string backend_;
+	size_t portfolio_size_;
+	size_t portfolio_clauses_;
+	double portfolio_time_;
+	size_t cube_threads_;
+	size_t cube_depth_;
+	double shape_seconds_;
+	double call_seconds_;
+	uint64_t call_conflicts_;
+	std::chrono::steady_clock::time_point start_time_;
+	std::string dump_prefix_;
+	bool tiles_isohedrally_;
+	bool timed_out_;
+
+	// The propagator connected to the solver of the last hole-free
+	// query, if any.  (Declared before solver_, so it outlives it.)
+	std::unique_ptr<HolePropagator<grid>> hole_prop_;
+
+	// The persistent solver used in incremental mode, the level it
+	// currently encodes, and the activation variable for that level.
+	std::unique_ptr<SATBackend> solver_;
+	size_t solver_level_;
+	var_id level_act_;
+
+	// The symmetries of the kernel that map the tiles to themselves, 
+	// the permutation each one induces on tiles (by conjugation), 
+	// and the auxiliary variables of its lex-leader chain.  A symmetry
+	// is dropped if the tiles ever fail to be closed under it.  All
+	// symmetry-breaking clauses are guarded by sym_sel_.
+	std::vector<xform_t> syms_;
+	std::vector<std::vector<tile_index>> sym_images_;
+	std::vector<std::vector<var_id>> sym_chains_;
+	var_id sym_sel_;
+
+	// When checking for coronas with holes, the clauses that forbid
+	// holes in the outer corona are guarded by hole_sel_, so that the
+	// hole-free query and the query with holes can share one solver.
+	var_id hole_sel_;
 };
 
 template<typename grid, typename coord>
@@ -187,21 +467,67 @@ void debugSolution(
 }
 
 template<typename grid>
-HeeschSolver<grid>::HeeschSolver( const Shape<grid>& shape, Orientations ori, bool reduce )
+HeeschSolver<grid>::HeeschSolver( const Shape<grid>& shape, Orientations ori, 
+		bool reduce, LevelEncoding enc )
 	: shape_ { shape }
 	, cloud_ { shape, ori, reduce }
-	, tiles_ {}
-	, cells_ {}
+	, encoding_ { enc }
+	, tile_xforms_ {}
+	, tile_vars_ {}
+	, tile_cells_ {}
+	, var_stride_ { 4 }
+	, cell_pos_ {}
+	, cell_vars_ {}
+	, cell_start_ {}
+	, cell_tiles_ {}
+	, cell_regs_ {}
+	, tile_overlaps_ {}
+	, tile_adjacents_ {}
+	, tile_hole_adjacents_ {}
+	, tile_halo_ {}
+	, halo_cells_ {}
 	, tile_map_ {}
 	, cell_map_ {}
+	, level_tiles_ {}
+	, fresh_tiles_ {}
+	, encoded_var_ { 0 }
+	, encoded_level_ { 0 }
 	, level_ { 0 }
 	, next_var_ { 0 }
 	, check_isohedral_ { false }
 	, check_hh_ { false }
+	, incremental_ { false }
+	, cell_amo_ { false }
+	, break_symmetry_ { false }
+	, warm_start_ { false }
+	, hole_propagation_ { false }
+	, warm_lits_ {}
+	, backend_ { "cryptominisat" }
+	, portfolio_size_ { 1 }
+	, portfolio_clauses_ { 0 }
+	, portfolio_time_ { 0.0 }
+	, cube_threads_ { 0 }
+	, cube_depth_ { 0 }
+	, shape_seconds_ { 0.0 }
+	, call_seconds_ { 0.0 }
+	, call_conflicts_ { 0 }
+	, start_time_ { std::chrono::steady_clock::now() }
+	, dump_prefix_ {}
 	, tiles_isohedrally_ { false }
+	, timed_out_ { false }
+	, hole_prop_ {}
+	, solver_ {}
+	, solver_level_ { 0 }
+	, level_act_ { 0 }
+	, syms_ {}
+	, sym_images_ {}
+	, sym_chains_ {}
+	, sym_sel_ { 0 }
+	, hole_sel_ { 0 }
 {
 	// Create the 0th corona.
 	getShapeVariable( grid::orientations[0], 0 );
+	indexCells();
 }
 
 template<typename grid>
@@ -213,11 +539,11 @@ var_id HeeschSolver<grid>::declareVariable()
 }
 
 template<typename grid>
-cell_index HeeschSolver<grid>::getTile( const xform_t& T ) const
+tile_index HeeschSolver<grid>::getTile( const xform_t& T ) const
 {
 	const auto& i = tile_map_.find( T );
 	if( i != tile_map_.end() ) {
-		return tiles_[ i->second ].index_;
+		return i->second;
 	}
 
 	return -1;
@@ -228,13 +554,13 @@ cell_index HeeschSolver<grid>::getCell( const point_t& p, bool create )
 {
 	auto i = cell_map_.find( p );
 	if( i != cell_map_.end() ) {
-		return cells_[i->second].index_;
+		return i->second;
 	}
 
 	if( create ) {
-		cell_index new_index = cells_.size();
-		cells_.emplace_back( p, new_index );
-		cells_.back().var_ = declareVariable();
+		cell_index new_index = cell_pos_.size();
+		cell_pos_.push_back( p );
+		cell_vars_.push_back( declareVariable() );
 		cell_map_[p] = new_index;
 		return new_index;
 	}
@@ -246,7 +572,7 @@ template<typename grid>
 var_id HeeschSolver<grid>::getCellVariable( const point_t& p )
 {
 	cell_index index = getCell( p, true );
-	return cells_[index].var_;
+	return cell_vars_[index];
 }
 
 template<typename grid>
@@ -254,7 +580,7 @@ var_id HeeschSolver<grid>::getCellVariable( const point_t& p ) const
 {
 	auto i = cell_map_.find( p );
 	if( i != cell_map_.end() ) {
-		return cells_[i->second].var_;
+		return cell_vars_[i->second];
 	}
 
 	std::cerr << "Tried to look up non-existent cell " << p 
@@ -272,22 +598,202 @@ bool HeeschSolver<grid>::hasCell( const point_t& p ) const
 template<typename grid>
 tile_index HeeschSolver<grid>::createNewTile( const xform_t& T )
 {
-	tile_index new_index = tiles_.size();
-	tiles_.emplace_back( T, new_index );
+	tile_index new_index = tile_xforms_.size();
+	tile_xforms_.push_back( T );
+	tile_vars_.resize( tile_vars_.size() + var_stride_, NO_VAR );
 	tile_map_[T] = new_index;
-	tile_info<grid>& ti = tiles_.back();
 
 	for( auto& p : shape_ ) {
 		point_t tp = T * p;
-		cell_index cidx = getCell( tp, true );
-		ti.cells_.push_back( cidx );
-
-		cells_[cidx].tiles_.push_back( new_index );
+		tile_cells_.push_back( getCell( tp, true ) );
 	}
 
+	tile_overlaps_.emplace_back();
+	tile_adjacents_.emplace_back();
+	tile_hole_adjacents_.emplace_back();
+	tile_halo_.push_back( NO_HALO );
+
+	linkNeighbours( new_index, cloud_.overlapping_, tile_overlaps_ );
+	linkNeighbours( new_index, cloud_.adjacent_unreduced_, tile_adjacents_ );
+	linkNeighbours( new_index, cloud_.adjacent_hole_, tile_hole_adjacents_ );
+
 	return new_index;
 }
 
+// Record the existing tiles at T*M for M in Ms as neighbours of the tile
+// at T, and vice versa.  All of the relations in the cloud are closed 
+// under inversion, so the relation holds in both directions.
+template<typename grid>
+void HeeschSolver<grid>::linkNeighbours( tile_index tidx, 
+	const xform_set<coord_t>& Ms, std::vector<std::vector<tile_index>>& nbrs )
+{
+	const xform_t& T = tile_xforms_[tidx];
+
+	for( auto& M : Ms ) {
+		tile_index index = getTile( T * M );
+		if( index != -1 ) {
+			nbrs[tidx].push_back( index );
+			nbrs[index].push_back( tidx );
+		}
+	}
+}
+
+// Look up the halo cells of a tile that has just become interior.  Every
+// halo cell should already be covered by some tile in the next corona,
+// but if one isn't, create it anyway.  It will have no tiles, so the
+// tile will be ruled out from interior coronas.
+template<typename grid>
+void HeeschSolver<grid>::findHalo( tile_index tidx )
+{
+	if( tile_halo_[tidx] != NO_HALO ) {
+		return;
+	}
+
+	const xform_t& T = tile_xforms_[tidx];
+	tile_halo_[tidx] = halo_cells_.size();
+	for( auto& p : cloud_.halo_ ) {
+		halo_cells_.push_back( getCell( T * p, true ) );
+	}
+}
+
+// Give every tile room for variables at levels 0 to width-1.
+template<typename grid>
+void HeeschSolver<grid>::widenVarTable( size_t width )
+{
+	std::vector<var_id> vars( numTiles() * width, NO_VAR );
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		std::copy_n( tile_vars_.begin() + tidx * var_stride_, var_stride_,
+			vars.begin() + tidx * width );
+	}
+	tile_vars_.swap( vars );
+	var_stride_ = width;
+}
+
+// Rebuild the cell-to-tile incidence lists from the tile-to-cell ones,
+// as a counting sort.  Each cell lists its tiles in order of creation.
+template<typename grid>
+void HeeschSolver<grid>::indexCells()
+{
+	size_t sz = shape_.size();
+
+	cell_start_.assign( cell_pos_.size() + 1, 0 );
+	for( auto cidx : tile_cells_ ) {
+		++cell_start_[cidx + 1];
+	}
+	for( size_t idx = 1; idx < cell_start_.size(); ++idx ) {
+		cell_start_[idx] += cell_start_[idx - 1];
+	}
+
+	std::vector<uint32_t> next( cell_start_.begin(), cell_start_.end() - 1 );
+	cell_tiles_.resize( tile_cells_.size() );
+	for( size_t idx = 0; idx < tile_cells_.size(); ++idx ) {
+		cell_tiles_[next[tile_cells_[idx]]++] = idx / sz;
+	}
+
+	if( cell_amo_ ) {
+		addCellRegisters();
+	}
+	if( break_symmetry_ ) {
+		updateSymmetries();
+	}
+}
+
+// Declare counter registers for tile cells that don't have one yet.
+// Tiles only ever join the end of a cell's list, so the registers of 
+// existing tiles remain valid as the patch grows.
+template<typename grid>
+void HeeschSolver<grid>::addCellRegisters()
+{
+	size_t idx = cell_regs_.size();
+	cell_regs_.resize( tile_cells_.size(), NO_VAR );
+	for( ; idx < cell_regs_.size(); ++idx ) {
+		cell_regs_[idx] = declareVariable();
+	}
+}
+
+template<typename grid>
+void HeeschSolver<grid>::setSymmetryBreaking( bool b )
+{
+	if( b == break_symmetry_ ) {
+		return;
+	}
+
+	break_symmetry_ = b;
+	syms_.clear();
+	sym_images_.clear();
+	sym_chains_.clear();
+	if( !b ) {
+		return;
+	}
+
+	// getSymmetries() reports only the orientations that fix the shape
+	// up to translation.  Recover the translations too.
+	std::vector<xform_t> oris;
+	shape_.getSymmetries( oris );
+
+	Shape<grid> sorted { shape_ };
+	sorted.complete();
+	Shape<grid> other;
+	for( const auto& O : oris ) {
+		other.reset( sorted, O );
+		syms_.push_back( O.translate( *sorted.begin() - *other.begin() ) );
+	}
+	sym_images_.resize( syms_.size() );
+	sym_chains_.resize( syms_.size() );
+
+	sym_sel_ = declareVariable();
+	updateSymmetries();
+}
+
+// Extend the tile permutations to newly created tiles, and drop any
+// symmetry under which the tiles (with their levels) aren't closed.
+// Make sure each chain has an auxiliary variable for every position.
+template<typename grid>
+void HeeschSolver<grid>::updateSymmetries()
+{
+	for( size_t g = syms_.size(); g > 0; --g ) {
+		const xform_t& S = syms_[g - 1];
+		xform_t Si = S.invert();
+		std::vector<tile_index>& images = sym_images_[g - 1];
+
+		for( size_t tidx = images.size(); tidx < numTiles(); ++tidx ) {
+			images.push_back( getTile( S * tile_xforms_[tidx] * Si ) );
+		}
+
+		bool closed = true;
+		size_t moved = 0;
+		for( size_t tidx = 0; closed && (tidx < numTiles()); ++tidx ) {
+			tile_index img = images[tidx];
+			if( img == -1 ) {
+				closed = false;
+				break;
+			}
+			for( size_t k = 0; k < var_stride_; ++k ) {
+				var_id v = tileVar( tidx, k );
+				var_id w = tileVar( img, k );
+				if( (v == NO_VAR) != (w == NO_VAR) ) {
+					closed = false;
+					break;
+				}
+				if( v != w ) {
+					++moved;
+				}
+			}
+		}
+
+		if( !closed ) {
+			syms_.erase( syms_.begin() + (g - 1) );
+			sym_images_.erase( sym_images_.begin() + (g - 1) );
+			sym_chains_.erase( sym_chains_.begin() + (g - 1) );
+			continue;
+		}
+
+		while( sym_chains_[g - 1].size() < moved ) {
+			sym_chains_[g - 1].push_back( declareVariable() );
+		}
+	}
+}
+
 template<typename grid>
 var_id HeeschSolver<grid>::getShapeVariable( const xform_t& T, size_t level )
 {
@@ -304,16 +810,25 @@ var_id HeeschSolver<grid>::getShapeVariable( const xform_t& T, size_t level )
 
 	// The location is in the map.  Now check if the variable exists
 	// for this level.
-	tile_info<grid>& ti = tiles_[index];
-
-	auto j = ti.vars_.find( level );
-	if( j == ti.vars_.end() ) {
-		var_id nv = declareVariable();
-		ti.vars_[level] = nv;
-		return nv;
-	} else {
-		return j->second;
+	if( level >= var_stride_ ) {
+		widenVarTable( std::max( level + 1, 2 * var_stride_ ) );
 	}
+
+	var_id *vars = &tile_vars_[index * var_stride_];
+	if( vars[level] == NO_VAR ) {
+		if( std::none_of( vars, vars + var_stride_, [this]( var_id v ) 
+				{ return (v != NO_VAR) && (v >= encoded_var_); } ) ) {
+			fresh_tiles_.push_back( index );
+		}
+		if( level_tiles_.size() <= level ) {
+			level_tiles_.resize( level + 1 );
+		}
+		level_tiles_[level].push_back( index );
+
+		vars[level] = declareVariable();
+	} 
+
+	return vars[level];
 }
 
 // Try to retrieve the variable for the given shape at the given level
@@ -328,18 +843,14 @@ bool HeeschSolver<grid>::getShapeVariable(
 		return false;
 	}
 
-	tile_index index = i->second;
-
 	// The location is in the map.  Now check if the variable exists
 	// for this level.
-	const tile_info<grid>& ti = tiles_[ index ];
-
-	auto j = ti.vars_.find( level );
-	if( j == ti.vars_.end() ) {
+	var_id v = tileVar( i->second, level );
+	if( v == NO_VAR ) {
 		return false;
 	}
 
-	id = j->second;
+	id = v;
 	return true;
 }
 
@@ -347,17 +858,23 @@ template<typename grid>
 void HeeschSolver<grid>::extendLevelWithTransforms(
 	size_t lev, const xform_set<coord_t>& Ts )
 {
-	size_t sz = tiles_.size();
+	size_t sz = numTiles();
 
 	for( size_t idx = 0; idx < sz; ++idx ) {
-		if( tiles_[idx].hasLevel( lev ) ) {
-			xform_t Told = tiles_[idx].T_;
+		if( tileVar( idx, lev ) != NO_VAR ) {
+			xform_t Told = tile_xforms_[idx];
 
 			for( const xform_t& T : Ts ) {
 				xform_t Tnew = Told * T;
 
-				// This is a small optimization -- coronas beyond the
-				// first can't be anywhere near the kernel.
+				// Coronas beyond the first can't be anywhere near the 
+				// kernel.  A tile that overlaps the kernel can never be
+				// used, and a tile adjacent to it can only be used in
+				// the 1-corona.  Every other (tile, level) pair has
+				// lev + 1 at least the tile's adjacency distance from the
+				// kernel by construction, and isn't ruled out by the 
+				// kernel alone.  (A tile that's hole-adjacent to the
+				// kernel can legitimately appear in an interior corona.)
 
 				// CSK: the check cloud_.isAny( Tnew ) worked for a long
 				// time, but was finally broken by a 14-kite in 2023.
@@ -367,14 +884,11 @@ void HeeschSolver<grid>::extendLevelWithTransforms(
 				// the kernel and were therefore eliminated.  Then, when
 				// we reached Level 2 and that shape tried to activate its
 				// halo, it discovered that some of those cells didn't have
-				// SAT variables!  
-
-				// It might be possible to keep this optimization and then
-				// to catch this problem at the other end, by treating
-				// the failure of getCellVariable() not as a fatal error,
-				// but as a sign that no corona can exist.  But it's a 
-				// small optimization, so just ignore it for now.
-				if( /* cloud_.isAny( Tnew ) || */ Tnew.isIdentity() ) {
+				// SAT variables!  Now findHalo() creates such cells, which
+				// are then covered by nothing and rule the shape out of 
+				// the interior, as they should.
+				if( Tnew.isIdentity() || cloud_.isOverlap( Tnew ) 
+						|| cloud_.isAdjacentUnreduced( Tnew ) ) {
 					continue;
 				}
 
@@ -403,6 +917,14 @@ void HeeschSolver<grid>::increaseLevel()
 		extendLevelWithTransforms( level_ - 1, cloud_.adjacent_ );
 	}
 
+	// The previous outer corona is now interior.
+	if( level_ <= level_tiles_.size() ) {
+		for( auto tidx : level_tiles_[level_ - 1] ) {
+			findHalo( tidx );
+		}
+	}
+	indexCells();
+
 	// std::cerr << "New level: " << level_ << "; dealing with " << 
 	//	tiles_.size() << " tiles." << std::endl;
 }
@@ -411,283 +933,1281 @@ template<typename grid>
 void HeeschSolver<grid>::addHolesToLevel()
 {
 	extendLevelWithTransforms( level_ - 1, cloud_.adjacent_hole_ );
+	indexCells();
 }
 
-inline CMSat::Lit pos( var_id id )
-{
-    return CMSat::Lit( id, false );
-}
-
-inline CMSat::Lit neg( var_id id )
-{
-	return CMSat::Lit( id, true );
-}
-
+// Clauses that depend on the current outer level are extended with the
+// literals in guard, if any.  Everything else remains valid as the 
+// patch grows, so it can be left permanently in an incremental solver.
+// In that case, from_var and from_level give a watermark: variables
+// numbered below from_var and tiles at levels below from_level have
+// already been encoded, and only the clauses they haven't seen yet are
+// generated.  (The level-dependent families are always regenerated
+// in full.)
 template<typename grid>
 void HeeschSolver<grid>::getClauses(
-	CMSat::SATSolver& solv, bool allow_holes ) const
+	SATBackend& solv, bool allow_holes, 
+	const std::vector<sat_lit>& guard, 
+	var_id from_var, size_t from_level ) const
 {
-	std::vector<CMSat::Lit> cl;
+	if( encoding_ == LADDER_LEVELS ) {
+		getLadderClauses( solv, allow_holes, guard, from_var, from_level );
+		return;
+	}
+
+	std::vector<sat_lit> cl;
+	size_t sz = shape_.size();
+
+	// The tiles that received variables since the watermark.
+	std::vector<tile_index> all_tiles;
+	const std::vector<tile_index> *fresh = &fresh_tiles_;
+	if( from_var == 0 ) {
+		for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+			all_tiles.push_back( tidx );
+		}
+		fresh = &all_tiles;
 
-	cl.push_back( pos( tiles_[0].vars_.at( 0 ) ) );
-	solv.add_clause( cl );
+		cl.push_back( pos( tileVar( 0, 0 ) ) );
+		solv.addClause( cl );
+	}
 
 	// If a copy of S is used, then its cells are used.
 	cl.resize( 2 );
-	for( auto& ti : tiles_ ) {
-		for( auto& p : shape_ ) {
-			point_t tp = ti.T_ * p;
-			cl[1] = pos( getCellVariable( tp ) );
-
-			for( auto& i : ti.vars_ ) {
-				cl[0] = neg( i.second );
-				solv.add_clause( cl );
+	for( auto tidx : *fresh ) {
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		const cell_index *cells = &tile_cells_[tidx * sz];
+		for( size_t idx = 0; idx < sz; ++idx ) {
+			cl[1] = pos( cell_vars_[cells[idx]] );
+
+			for( size_t k = 0; k < var_stride_; ++k ) {
+				if( (vars[k] != NO_VAR) && (vars[k] >= from_var) ) {
+					cl[0] = neg( vars[k] );
+					solv.addClause( cl );
+				}
 			}
 		}
 	}
 
-	// If a cell is used, then some copy of S must use it.
-	for( auto& ci : cells_ ) {
+	// If a cell is used, then some copy of S must use it.  (Guarded, 
+	// because later levels can add more copies that use the cell.)
+	for( size_t cidx = 0; cidx < cell_vars_.size(); ++cidx ) {
 		cl.clear();
-		cl.push_back( neg( ci.var_ ) );
-		for( auto& tindex : ci.tiles_ ) {
-			auto& ti = tiles_[tindex];
-			for( auto& i : ti.vars_ ) {
-				cl.push_back( pos( i.second ) );
+		cl.push_back( neg( cell_vars_[cidx] ) );
+		for( size_t idx = cell_start_[cidx]; idx < cell_start_[cidx+1]; ++idx ) {
+			const var_id *vars = &tile_vars_[cell_tiles_[idx] * var_stride_];
+			for( size_t k = 0; k < var_stride_; ++k ) {
+				if( vars[k] != NO_VAR ) {
+					cl.push_back( pos( vars[k] ) );
+				}
 			}
 		}
-		solv.add_clause( cl );
+		cl.insert( cl.end(), guard.begin(), guard.end() );
+		solv.addClause( cl );
 	}
 
 	// If a copy of S is used in an interior corona (a k-corona for k < n),
-	// then that copy’s halo cells must be used.
+	// then that copy’s halo cells must be used.  Copies at levels below
+	// from_level were already interior at the last encoding.
 	cl.resize( 2 );
-	for( auto& ti : tiles_ ) {
-		for( auto& i : ti.vars_ ) {
-			if( i.first < level_ ) {
-				// This is a tile variable at an inner corona.
-				cl[0] = neg( i.second );
-				for( auto& p : cloud_.halo_ ) {
-					point_t tp = ti.T_ * p;
-					cl[1] = pos( getCellVariable( tp ) );
-					solv.add_clause( cl );
-				}
+	for( size_t k = from_level; k < std::min( level_, level_tiles_.size() ); ++k ) {
+		for( auto tidx : level_tiles_[k] ) {
+			const cell_index *halo = &halo_cells_[tile_halo_[tidx]];
+			// This is a tile variable at an inner corona.
+			cl[0] = neg( tileVar( tidx, k ) );
+			for( size_t idx = 0; idx < cloud_.halo_.size(); ++idx ) {
+				cl[1] = pos( cell_vars_[halo[idx]] );
+				solv.addClause( cl );
 			}
 		}
 	}
 
-	// Used copies of S cannot overlap.
+	// Used copies of S cannot overlap.  In at-most-one mode, walk the
+	// tiles over each cell in order, with register r_i true if any of
+	// the first i tiles is used: each variable x of tile i gives
+	// x -> r_i and x -> !r_{i-1}, and r_{i-1} -> r_i.  Clauses whose
+	// variables are all below the watermark were emitted before.
 	cl.resize( 2 );
-	for( auto& ti : tiles_ ) {
-		for( auto& M : cloud_.overlapping_ ) {
-			xform_t Tn = ti.T_ * M;
-			// OK, so is there a tile located at Tn?
-			tile_index index = getTile( Tn );
-			if( index == -1 ) {
-				continue;
+	if( cell_amo_ ) {
+		for( size_t cidx = 0; cidx < cell_vars_.size(); ++cidx ) {
+			var_id prev = NO_VAR;
+			for( size_t idx = cell_start_[cidx]; idx < cell_start_[cidx+1]; ++idx ) {
+				tile_index tidx = cell_tiles_[idx];
+				const var_id *vars = &tile_vars_[tidx * var_stride_];
+				const cell_index *cells = &tile_cells_[tidx * sz];
+				var_id reg = cell_regs_[
+					tidx * sz + (std::find( cells, cells + sz, cidx ) - cells)];
+
+				for( size_t k = 0; k < var_stride_; ++k ) {
+					if( vars[k] == NO_VAR ) {
+						continue;
+					}
+					cl[0] = neg( vars[k] );
+					if( std::max( vars[k], reg ) >= from_var ) {
+						cl[1] = pos( reg );
+						solv.addClause( cl );
+					}
+					if( (prev != NO_VAR) && (std::max( vars[k], prev ) >= from_var) ) {
+						cl[1] = neg( prev );
+						solv.addClause( cl );
+					}
+				}
+				if( (prev != NO_VAR) && (std::max( prev, reg ) >= from_var) ) {
+					cl[0] = neg( prev );
+					cl[1] = pos( reg );
+					solv.addClause( cl );
+				}
+				prev = reg;
 			}
-			auto& tj = tiles_[index];
-
-			// There's a tile here. Prevent all pairwise overlaps
-			// at all levels.
-			for( auto& i : ti.vars_ ) {
-				for( auto& j : tj.vars_ ) {
-					cl[0] = neg( i.second );
-					cl[1] = neg( j.second );
-					solv.add_clause( cl );
+		}
+	} else {
+		// Otherwise, forbid each pair of variables of overlapping tiles.
+		// Each pair is visited from both ends; emit it only once, from the 
+		// newer end.
+		for( auto tidx : *fresh ) {
+			const var_id *vars = &tile_vars_[tidx * var_stride_];
+			for( auto index : tile_overlaps_[tidx] ) {
+				const var_id *nvars = &tile_vars_[index * var_stride_];
+
+				// Prevent all pairwise overlaps at all levels.
+				for( size_t k = 0; k < var_stride_; ++k ) {
+					if( (vars[k] == NO_VAR) || (vars[k] < from_var) ) {
+						continue;
+					}
+					for( size_t j = 0; j < var_stride_; ++j ) {
+						if( (nvars[j] == NO_VAR) 
+								|| ((nvars[j] >= from_var) && (nvars[j] < vars[k])) ) {
+							continue;
+						}
+						cl[0] = neg( vars[k] );
+						cl[1] = neg( nvars[j] );
+						solv.addClause( cl );
+					}
 				}
 			}
 		}
 	}
-	
-	// Used copies of S cannot overlap.
+
 	// If a copy of S is used in a k-corona, it must be adjacent to a copy
 	// in a (k−1)-corona
 	// If a copy of S is used in a k-corona, it cannot be adjacent to a
 	// copy in an m-corona for m < k − 1.
-	for( auto& ti : tiles_ ) {
-		for( auto& i : ti.vars_ ) {
-			size_t k = i.first;
-			if( k < 1 ) {
+	for( auto tidx : *fresh ) {
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		for( size_t k = 1; k < var_stride_; ++k ) {
+			if( (vars[k] == NO_VAR) || (vars[k] < from_var) ) {
 				continue;
 			}
 			cl.clear();
-			cl.push_back( neg( i.second ) );
-			for( auto& M : cloud_.adjacent_unreduced_ ) {
-				xform_t Tn = ti.T_ * M;
-				tile_index index = getTile( Tn );
-				if( index == -1 ) {
-					continue;
-				}
-				auto& tj = tiles_[index];
-				for( auto& j : tj.vars_ ) {
-					if( j.first == k - 1 ) {
-						cl.push_back( pos( j.second ) );
-					} else if( j.first < k - 1 ) {
-						std::vector<CMSat::Lit> cl2;
-						cl2.push_back( neg( i.second ) );
-						cl2.push_back( neg( j.second ) );
-						solv.add_clause( cl2 );
+			cl.push_back( neg( vars[k] ) );
+			for( auto index : tile_adjacents_[tidx] ) {
+				const var_id *nvars = &tile_vars_[index * var_stride_];
+				for( size_t j = 0; j < k; ++j ) {
+					if( nvars[j] == NO_VAR ) {
+						continue;
+					}
+					if( j == k - 1 ) {
+						cl.push_back( pos( nvars[j] ) );
+					} else {
+						std::vector<sat_lit> cl2;
+						cl2.push_back( neg( vars[k] ) );
+						cl2.push_back( neg( nvars[j] ) );
+						solv.addClause( cl2 );
 					}
 				}
 			}
 
 			if( cl.size() > 1 ) {
-				solv.add_clause( cl );
-			}
-
-			if( !allow_holes && (k == level_) ) {
-				// outermost corona, no holes allowed.  Walk over the
-				// hole_adjacencies and forbid them.
-				cl.resize( 2 );
-
-				for( auto& M : cloud_.adjacent_hole_ ) {
-					xform_t Tn = ti.T_ * M;
-					tile_index index = getTile( Tn );
-					if( index == -1 ) {
-						continue;
-					}
-					auto& tj = tiles_[index];
-					if( tj.hasLevel( k ) ) {
-						cl[0] = neg( i.second );
-						cl[1] = neg( tj.vars_.at( k ) );
-						solv.add_clause( cl );
-					}
-				}
+				solv.addClause( cl );
 			}
 		}
 	}
-}
 
-template<typename grid>
-void HeeschSolver<grid>::getSolution( 
-	const CMSat::SATSolver& solv, Solution<coord_t>& ret ) const
-{
-	ret.clear();
-	const std::vector<CMSat::lbool>& model = solv.get_model();
-	for( auto& ti : tiles_ ) {
-		for( auto& i : ti.vars_ ) {
-			if( model[i.second] == CMSat::l_True ) {
-				ret.emplace_back( i.first, ti.T_ );
-				break;
+	if( allow_holes || (level_ >= level_tiles_.size()) ) {
+		return;
+	}
+
+	// Outermost corona, no holes allowed.  Walk over the hole adjacencies
+	// and forbid them.  (Guarded, because the next level will make this
+	// corona interior.)  Each pair is emitted once, from its lower index.
+	cl.resize( 2 );
+	cl.insert( cl.end(), guard.begin(), guard.end() );
+	for( auto tidx : level_tiles_[level_] ) {
+		cl[0] = neg( tileVar( tidx, level_ ) );
+
+		for( auto index : tile_hole_adjacents_[tidx] ) {
+			if( index < tidx ) {
+				continue;
+			}
+			var_id v = tileVar( index, level_ );
+			if( v != NO_VAR ) {
+				cl[1] = neg( v );
+				solv.addClause( cl );
 			}
 		}
 	}
+
+	getHoleTupleClauses( solv, guard );
 }
 
+// Forbid the sets of copies found by Cloud::findHoleTuples() from all 
+// being used in the outermost corona, like hole-adjacent pairs.  The
+// hole they enclose can't be filled, so they could never be part of a
+// hole-free corona.  (Guarded.)  The sets are looked up through the
+// outer tiles adjacent to each one, and a set can turn up more than 
+// once; emit it only the first time.
 template<typename grid>
-bool HeeschSolver<grid>::hasCorona( 
-	bool get_solution, bool& has_holes, Solution<coord_t>& soln ) 
+void HeeschSolver<grid>::getHoleTupleClauses( SATBackend& solv, 
+	const std::vector<sat_lit>& guard ) const
 {
-	if( level_ == 0 ) {
-		// A hole-free 0-corona always exists.
-		has_holes = false;
-		if( get_solution ) {
-			soln.push_back( std::make_pair( 0, grid::orientations[0] ) );
-		}
-		// std::cout << "Asking for 0-corona" << std::endl;
-		return true;
-	}
-
-	if( !cloud_.surroundable_ ) {
-		// std::cout << "Not surroundable at all" << std::endl;
-		return false;
+	if( cloud_.hole_tuples_.empty() ) {
+		return;
 	}
 
-	CMSat::SATSolver solver;
-	solver.new_vars( next_var_ );
-
-	getClauses( solver, false );
-
-	if( solver.solve() == CMSat::l_True ) {
-		// Got a solution, but it may have large holes.  Need to find
-		// them and iterate until they're gone.
+	std::set<std::vector<tile_index>> done;
+	std::vector<tile_index> tuple;
+	std::vector<sat_lit> cl;
 
-		has_holes = true;
-		if( get_solution ) {
-			getSolution( solver, soln );
-			// debugSolution( std::cout, shape_, soln );
-		}
+	for( auto tidx : level_tiles_[level_] ) {
+		xform_t Ti = tile_xforms_[tidx].invert();
 
-		while( true ) {
-			const std::vector<CMSat::lbool>& model = solver.get_model();
-			HoleFinder<grid> finder { shape_ };
+		for( auto adj : tile_adjacents_[tidx] ) {
+			if( tileVar( adj, level_ ) == NO_VAR ) {
+				continue;
+			}
+			auto i = cloud_.hole_tuples_.find( Ti * tile_xforms_[adj] );
+			if( i == cloud_.hole_tuples_.end() ) {
+				continue;
+			}
 
-			for( auto& ti : tiles_ ) {
-				for( auto i : ti.vars_ ) {
-					if( model[i.second] == CMSat::l_True ) {
-						finder.addCopy( ti.index_, ti.T_ );
+			for( const auto& Ms : i->second ) {
+				tuple.clear();
+				tuple.push_back( tidx );
+				tuple.push_back( adj );
+				for( const auto& M : Ms ) {
+					tile_index index = getTile( tile_xforms_[tidx] * M );
+					if( (index == -1) 
+							|| (tileVar( index, level_ ) == NO_VAR) ) {
 						break;
 					}
+					tuple.push_back( index );
 				}
-			}
-
-			std::vector<std::vector<tile_index>> holes;
-			if( !finder.getHoles( holes ) ) {
-				// Found a hole-free solution!
-				has_holes = false;
-				if( get_solution ) {
-					getSolution( solver, soln );
+				if( tuple.size() < Ms.size() + 2 ) {
+					continue;
 				}
 
-				// If the client has asked for checking isohedral tiling,
-				// this is the place to do it -- after constructing the
-				// clauses for level-1 surroundability, finding a surround
-				// with no holes.
-				if( (level_ == 1) && check_isohedral_ ) {
-					if( checkIsohedralTiling( solver ) ) {
-						return false;
-					}
+				std::sort( tuple.begin(), tuple.end() );
+				if( !done.insert( tuple ).second ) {
+					continue;
 				}
 
-				return true;
-			}
-
-			std::vector<CMSat::Lit> cl;
-			for( auto& hole : holes ) {
 				cl.clear();
-				// std::cout << "Forbidding a hole:";
-				for( auto& index : hole ) {
-					// We know that there's a variable at the top level,
-					// otherwise we wouldn't have found a hole in the
-					// first place.
-					cl.push_back( neg( tiles_[index].vars_.at( level_ ) ) );
-					// std::cout << " " << index;
+				for( auto index : tuple ) {
+					excludeLevel( index, level_, cl );
 				}
-				// std::cout << std::endl;
-				solver.add_clause( cl );
+				cl.insert( cl.end(), guard.begin(), guard.end() );
+				solv.addClause( cl );
 			}
+		}
+	}
+}
+
+// Add the literals that rule out the tile being used at exactly the
+// given level, which it must have a variable for.
+template<typename grid>
+void HeeschSolver<grid>::excludeLevel( 
+	tile_index tidx, size_t level, std::vector<sat_lit>& cl ) const
+{
+	cl.push_back( neg( tileVar( tidx, level ) ) );
+	if( (encoding_ == LADDER_LEVELS) && (level > 0) ) {
+		var_id below = levelAtMost( tidx, level - 1 );
+		if( below != NO_VAR ) {
+			cl.push_back( pos( below ) );
+		}
+	}
+}
+
+// The clauses of the ladder encoding.  A tile is used at all if and only
+// if the variable at its highest level is true, so the families that
+// don't care about levels need only that one variable.  Here, a clause 
+// that isn't level-dependent is new exactly when it mentions a variable
+// at or above from_var.
+template<typename grid>
+void HeeschSolver<grid>::getLadderClauses(
+	SATBackend& solv, bool allow_holes, 
+	const std::vector<sat_lit>& guard, 
+	var_id from_var, size_t from_level ) const
+{
+	std::vector<sat_lit> cl;
+	size_t sz = shape_.size();
+
+	auto add_new = [&solv, from_var]( const std::vector<sat_lit>& c ) {
+		for( auto& l : c ) {
+			if( litVar( l ) >= from_var ) {
+				solv.addClause( c );
+				return;
+			}
+		}
+	};
+	auto top = [this]( tile_index tidx ) {
+		return levelAtMost( tidx, var_stride_ - 1 );
+	};
+
+	std::vector<tile_index> all_tiles;
+	const std::vector<tile_index> *fresh = &fresh_tiles_;
+	if( from_var == 0 ) {
+		for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+			all_tiles.push_back( tidx );
+		}
+		fresh = &all_tiles;
+
+		cl.push_back( pos( tileVar( 0, 0 ) ) );
+		solv.addClause( cl );
+	}
+
+	// Each tile's variables form a chain: if it's used at level <= j,
+	// it's used at level <= k for the next level k that it has.  And if
+	// it's used at all, its cells are used.
+	cl.resize( 2 );
+	for( auto tidx : *fresh ) {
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		var_id prev = NO_VAR;
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			if( vars[k] == NO_VAR ) {
+				continue;
+			}
+			if( prev != NO_VAR ) {
+				cl[0] = neg( prev );
+				cl[1] = pos( vars[k] );
+				add_new( cl );
+			}
+			prev = vars[k];
+		}
+
+		cl[0] = neg( prev );
+		for( size_t idx = 0; idx < sz; ++idx ) {
+			cl[1] = pos( cell_vars_[tile_cells_[tidx * sz + idx]] );
+			add_new( cl );
+		}
+	}
+
+	// If a cell is used, then some copy of S must use it.  (Guarded.)
+	for( size_t cidx = 0; cidx < cell_vars_.size(); ++cidx ) {
+		cl.clear();
+		cl.push_back( neg( cell_vars_[cidx] ) );
+		for( size_t idx = cell_start_[cidx]; idx < cell_start_[cidx+1]; ++idx ) {
+			cl.push_back( pos( top( cell_tiles_[idx] ) ) );
+		}
+		cl.insert( cl.end(), guard.begin(), guard.end() );
+		solv.addClause( cl );
+	}
+
+	// If a copy of S is used in an interior corona, then its halo cells 
+	// must be used.  It suffices to say this for the tile's highest 
+	// interior level, which every interior level implies.
+	cl.resize( 2 );
+	for( size_t k = from_level; k < std::min( level_, level_tiles_.size() ); ++k ) {
+		for( auto tidx : level_tiles_[k] ) {
+			if( levelAtMost( tidx, level_ - 1 ) != tileVar( tidx, k ) ) {
+				continue;
+			}
+			const cell_index *halo = &halo_cells_[tile_halo_[tidx]];
+			cl[0] = neg( tileVar( tidx, k ) );
+			for( size_t idx = 0; idx < cloud_.halo_.size(); ++idx ) {
+				cl[1] = pos( cell_vars_[halo[idx]] );
+				solv.addClause( cl );
+			}
+		}
+	}
+
+	// Used copies of S cannot overlap, which needs only one clause per
+	// overlapping pair (or one counter step per tile and cell).
+	if( cell_amo_ ) {
+		for( size_t cidx = 0; cidx < cell_vars_.size(); ++cidx ) {
+			var_id prev = NO_VAR;
+			for( size_t idx = cell_start_[cidx]; idx < cell_start_[cidx+1]; ++idx ) {
+				tile_index tidx = cell_tiles_[idx];
+				const cell_index *cells = &tile_cells_[tidx * sz];
+				var_id reg = cell_regs_[
+					tidx * sz + (std::find( cells, cells + sz, cidx ) - cells)];
+
+				cl[0] = neg( top( tidx ) );
+				cl[1] = pos( reg );
+				add_new( cl );
+				if( prev != NO_VAR ) {
+					cl[1] = neg( prev );
+					add_new( cl );
+					cl[0] = neg( prev );
+					cl[1] = pos( reg );
+					add_new( cl );
+				}
+				prev = reg;
+			}
+		}
+	} else {
+		for( auto tidx : *fresh ) {
+			for( auto index : tile_overlaps_[tidx] ) {
+				if( (index < tidx) && (top( index ) >= from_var) ) {
+					// Also fresh; handled from the other end.
+					continue;
+				}
+				cl[0] = neg( top( tidx ) );
+				cl[1] = neg( top( index ) );
+				add_new( cl );
+			}
+		}
+	}
+
+	// If a copy of S is used in a k-corona, it must be adjacent to a copy
+	// used at level <= k-1 (and so, by the next family, at level k-1).
+	for( auto tidx : *fresh ) {
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		for( size_t k = 1; k < var_stride_; ++k ) {
+			if( (vars[k] == NO_VAR) || (vars[k] < from_var) ) {
+				continue;
+			}
+			cl.clear();
+			cl.push_back( neg( vars[k] ) );
+			var_id below = levelAtMost( tidx, k - 1 );
+			if( below != NO_VAR ) {
+				cl.push_back( pos( below ) );
+			}
+			for( auto index : tile_adjacents_[tidx] ) {
+				var_id v = levelAtMost( index, k - 1 );
+				if( v != NO_VAR ) {
+					cl.push_back( pos( v ) );
+				}
+			}
+			solv.addClause( cl );
+		}
+	}
+
+	// Adjacent copies of S must be used at levels at most one apart: if
+	// one is used at level <= j, the other can't be used unless it's at
+	// level <= j+1.  This needs one clause per level of the pair, rather
+	// than one per pair of levels.
+	auto separate = [&]( tile_index lo, tile_index hi ) {
+		const var_id *vars = &tile_vars_[lo * var_stride_];
+		var_id hi_top = top( hi );
+		for( size_t j = 0; j + 2 < var_stride_; ++j ) {
+			var_id v = levelAtMost( hi, j + 1 );
+			if( (vars[j] == NO_VAR) || (v == hi_top) ) {
+				// Either lo has no level j, or hi has nothing above j+1.
+				continue;
+			}
+			cl.clear();
+			cl.push_back( neg( vars[j] ) );
+			cl.push_back( neg( hi_top ) );
+			if( v != NO_VAR ) {
+				cl.push_back( pos( v ) );
+			}
+			add_new( cl );
+		}
+	};
+
+	for( auto tidx : *fresh ) {
+		for( auto index : tile_adjacents_[tidx] ) {
+			if( (index < tidx) && (top( index ) >= from_var) ) {
+				continue;
+			}
+			separate( tidx, index );
+			separate( index, tidx );
+		}
+	}
+
+	if( allow_holes || (level_ >= level_tiles_.size()) ) {
+		return;
+	}
+
+	// Outermost corona, no holes allowed.  (Guarded.)
+	for( auto tidx : level_tiles_[level_] ) {
+		for( auto index : tile_hole_adjacents_[tidx] ) {
+			if( (index < tidx) || (tileVar( index, level_ ) == NO_VAR) ) {
+				continue;
+			}
+			cl.clear();
+			excludeLevel( tidx, level_, cl );
+			excludeLevel( index, level_, cl );
+			cl.insert( cl.end(), guard.begin(), guard.end() );
+			solv.addClause( cl );
+		}
+	}
+
+	getHoleTupleClauses( solv, guard );
+}
 
-			if( solver.solve() == CMSat::l_False ) {
+// For each symmetry g, require the tile variables, read in order of
+// tile and level, to be lexicographically no greater than their images
+// under g.  Auxiliary variable a_i is forced true when the first i
+// moved positions are equal, in which case x_i <= g(x_i).  These clauses
+// refer to the current outer level only through the variables that 
+// exist, so they're regenerated in full and guarded.
+template<typename grid>
+void HeeschSolver<grid>::getSymmetryClauses( SATBackend& solv, 
+	const std::vector<sat_lit>& guard ) const
+{
+	std::vector<sat_lit> cl;
+
+	for( size_t g = 0; g < syms_.size(); ++g ) {
+		const std::vector<tile_index>& images = sym_images_[g];
+		const std::vector<var_id>& chain = sym_chains_[g];
+		size_t pos_idx = 0;
+
+		for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+			for( size_t k = 0; k < var_stride_; ++k ) {
+				var_id x = tileVar( tidx, k );
+				var_id y = tileVar( images[tidx], k );
+				if( x == y ) {
+					continue;
+				}
+				var_id a = chain[pos_idx];
+
+				auto emit = [&]( sat_lit l1, sat_lit l2 ) {
+					cl.clear();
+					if( pos_idx > 0 ) {
+						cl.push_back( neg( chain[pos_idx - 1] ) );
+					}
+					cl.push_back( l1 );
+					cl.push_back( l2 );
+					cl.insert( cl.end(), guard.begin(), guard.end() );
+					solv.addClause( cl );
+				};
+
+				emit( neg( x ), pos( y ) );
+				emit( neg( x ), pos( a ) );
+				emit( pos( y ), pos( a ) );
+				++pos_idx;
+			}
+		}
+	}
+}
+
+template<typename grid>
+void HeeschSolver<grid>::getSolution( 
+	const SATBackend& solv, Solution<coord_t>& ret ) const
+{
+	ret.clear();
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		const var_id *vars = &tile_vars_[tidx * var_stride_];
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			if( (vars[k] != NO_VAR) && solv.value( vars[k] ) ) {
+				ret.emplace_back( k, tile_xforms_[tidx] );
+				break;
+			}
+		}
+	}
+}
+
+template<typename grid>
+bool HeeschSolver<grid>::hasCorona( 
+	bool get_solution, bool& has_holes, Solution<coord_t>& soln ) 
+{
+	if( level_ == 0 ) {
+		// A hole-free 0-corona always exists.
+		has_holes = false;
+		if( get_solution ) {
+			soln.push_back( std::make_pair( 0, grid::orientations[0] ) );
+		}
+		// std::cout << "Asking for 0-corona" << std::endl;
+		return true;
+	}
+
+	if( !cloud_.surroundable_ ) {
+		// std::cout << "Not surroundable at all" << std::endl;
+		return false;
+	}
+
+	if( cube_threads_ > 0 ) {
+		SATResult res = solveCubes( get_solution, has_holes, soln );
+		if( res == SAT_SATISFIABLE ) {
+			if( !has_holes && (level_ == 1) && check_isohedral_ ) {
+				auto iso = makeSolver();
+				iso->newVars( next_var_ );
+				getClauses( *iso, false );
+				if( checkIsohedralTiling( *iso ) || timed_out_ ) {
+					return false;
+				}
+			}
+			return true;
+		} else if( (res == SAT_UNKNOWN) || !check_hh_ ) {
+			return false;
+		} else {
+			return hasHoleCorona( get_solution, has_holes, soln );
+		}
+	}
+
+	std::unique_ptr<SATBackend> fresh;
+	SATBackend *solver;
+	std::vector<sat_lit> assumps;
+	std::vector<sat_lit> guard;
+
+	if( incremental_ ) {
+		var_id act;
+		solver = &getIncrementalSolver( act );
+		assumps.push_back( pos( act ) );
+		guard.push_back( neg( act ) );
+	} else {
+		fresh = makeSolver();
+		solver = fresh.get();
+	}
+	if( check_hh_ ) {
+		// Leave room to drop the hole-free clauses later.
+		guard.push_back( pos( hole_sel_ ) );
+	}
+	if( !incremental_ ) {
+		solver->newVars( next_var_ );
+		getClauses( *solver, false, guard );
+		getSymmetryClauses( *solver, { neg( sym_sel_ ) } );
+		// Only tiles from here on matter to the re-encoding below.
+		encoded_var_ = next_var_;
+		fresh_tiles_.clear();
+	}
+
+	// The assumptions shared by the hole-free query and the query with
+	// holes, if any.
+	std::vector<sat_lit> hh_assumps { assumps };
+	if( check_hh_ ) {
+		assumps.push_back( neg( hole_sel_ ) );
+		hh_assumps.push_back( pos( hole_sel_ ) );
+	}
+	// The isohedral check runs without symmetry breaking.
+	std::vector<sat_lit> iso_assumps { assumps };
+	if( break_symmetry_ ) {
+		assumps.push_back( pos( sym_sel_ ) );
+	}
+
+	if( hole_propagation_ ) {
+		auto prop = makeHolePropagator( guard );
+		if( solver->setPropagator( prop.get() ) ) {
+			hole_prop_ = std::move( prop );
+		}
+	}
+
+	std::vector<sat_lit> soft;
+	if( warm_start_ ) {
+		soft = warm_lits_;
+		for( auto l : soft ) {
+			solver->setPhase( l );
+		}
+	}
+
+	dumpCNF( *solver, assumps, "" );
+	SATResult res = solveWarm( *solver, assumps, soft );
+	if( res == SAT_SATISFIABLE ) {
+		// Got a solution, but it may have large holes.  Need to find
+		// them and iterate until they're gone.
+
+		has_holes = true;
+		if( get_solution ) {
+			getSolution( *solver, soln );
+			// debugSolution( std::cout, shape_, soln );
+		}
+
+		HoleFinder<grid> finder { shape_, cell_pos_ };
+		std::vector<std::vector<sat_lit>> blocks;
+		while( true ) {
+			blocks.clear();
+			if( !getHoleClauses( *solver, guard, finder, blocks ) ) {
+				// Found a hole-free solution!
+				has_holes = false;
+				if( get_solution ) {
+					getSolution( *solver, soln );
+				}
+				if( warm_start_ ) {
+					recordWarmStart( *solver );
+				}
+
+				// If the client has asked for checking isohedral tiling,
+				// this is the place to do it -- after constructing the
+				// clauses for level-1 surroundability, finding a surround
+				// with no holes.  The check retires its own clauses 
+				// afterwards, so an incremental solver can carry on to
+				// the next level.
+				if( (level_ == 1) && check_isohedral_ ) {
+					if( checkIsohedralTiling( *solver, iso_assumps ) 
+							|| timed_out_ ) {
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			for( const auto& cl : blocks ) {
+				solver->addClause( cl );
+			}
+
+			dumpCNF( *solver, assumps, "" );
+			res = solveWarm( *solver, assumps, soft );
+			if( res == SAT_UNKNOWN ) {
+				// We can't tell whether a hole-free corona exists.
+				return false;
+			} else if( res == SAT_UNSATISFIABLE ) {
 				// Ran out of options; revert to the already captured 
 				// solution with holes.
 				// std::cout << "No longer solvable" << std::endl;
 				return true;
 			}
 		}
-	} else if( check_hh_ ) {
-		// No solution found yet.  If requested, try a larger solution by 
-		// allowing holes in the outer corona.
-		// std::cout << "Adding holes to level" << std::endl;
-		addHolesToLevel();
+	} else if( res == SAT_UNKNOWN ) {
+		return false;
+	} else if( !check_hh_ ) {
+		return false;
+	}
+
+	// No hole-free corona exists at this level, so try a larger solution
+	// by allowing holes in the outer corona.  Encode the new tiles into
+	// the same solver, switch off the hole-free clauses with hole_sel_ 
+	// and turn on replacements for them that count the new tiles.  The
+	// new tiles can break the symmetries, so don't assume sym_sel_.
+	if( hole_propagation_ ) {
+		solver->setPropagator( nullptr );
+	}
+	var_id from_var = next_var_;
+	addHolesToLevel();
+	solver->newVars( next_var_ - solver->numVars() );
+	guard.back() = neg( hole_sel_ );
+	getClauses( *solver, true, guard, from_var, level_ );
+	encoded_var_ = next_var_;
+	fresh_tiles_.clear();
+
+	dumpCNF( *solver, hh_assumps, "h" );
+	if( solveWithinBudget( *solver, hh_assumps ) == SAT_SATISFIABLE ) {
+		has_holes = true;
+		if( get_solution ) {
+			getSolution( *solver, soln );
+		}
+		return true;
+	} else {
+		return false;
+	}
+}
+
+template<typename grid>
+bool HeeschSolver<grid>::checkIsohedral()
+{
+	if( !cloud_.surroundable_ ) {
+		return false;
+	}
+
+	auto solver = makeSolver();
+	solver->newVars( next_var_ );
+	getClauses( *solver, false );
+	return checkIsohedralTiling( *solver );
+}
+
+// No hole-free corona exists at this level, so try a larger solution by 
+// allowing holes in the outer corona, in a solver of its own.  (Used 
+// after cube-and-conquer, which has no single solver to reuse.)
+template<typename grid>
+bool HeeschSolver<grid>::hasHoleCorona( 
+	bool get_solution, bool& has_holes, Solution<coord_t>& soln )
+{
+	// std::cout << "Adding holes to level" << std::endl;
+	addHolesToLevel();
+
+	auto solver = makeSolver();
+	solver->newVars( next_var_ );
+	getClauses( *solver, true );
+	getSymmetryClauses( *solver, { neg( sym_sel_ ) } );
+
+	std::vector<sat_lit> sym_assumps;
+	if( break_symmetry_ ) {
+		sym_assumps.push_back( pos( sym_sel_ ) );
+	}
+	dumpCNF( *solver, sym_assumps, "h" );
+	if( solveWithinBudget( *solver, sym_assumps ) == SAT_SATISFIABLE ) {
+		has_holes = true;
+		if( get_solution ) {
+			getSolution( *solver, soln );
+		}
+		// std::cout << "Found solution with holes" << std::endl;
+		return true;
+	} else {
+		// std::cout << "No solution with holes" << std::endl;
+		return false;
+	}
+}
 
-		CMSat::SATSolver solver;
-		solver.new_vars( next_var_ );
-		getClauses( solver, true );
-		if( solver.solve() == CMSat::l_True ) {
-			has_holes = true;
-			if( get_solution ) {
-				getSolution( solver, soln );
+// Solve with the soft assumptions added, if there are any left, and
+// drop them for good if that fails.  The attempt with them gets only 
+// WARM_CONFLICTS conflicts; running out counts as failing, and the
+// plain solve that follows gets the usual budget.
+template<typename grid>
+SATResult HeeschSolver<grid>::solveWarm( SATBackend& solv, 
+	const std::vector<sat_lit>& assumps, std::vector<sat_lit>& soft )
+{
+	if( !soft.empty() ) {
+		if( !applyBudget( solv ) ) {
+			timed_out_ = true;
+			return SAT_UNKNOWN;
+		}
+		solv.setConflictBudget( (call_conflicts_ > 0) 
+			? std::min( call_conflicts_, WARM_CONFLICTS ) : WARM_CONFLICTS );
+
+		std::vector<sat_lit> all { assumps };
+		all.insert( all.end(), soft.begin(), soft.end() );
+		SATResult res = solv.solve( all );
+		if( res == SAT_SATISFIABLE ) {
+			return res;
+		}
+		soft.clear();
+	}
+
+	return solveWithinBudget( solv, assumps );
+}
+
+// Remember the tiles of a hole-free corona (apart from the kernel) for
+// warm-starting the next level.
+template<typename grid>
+void HeeschSolver<grid>::recordWarmStart( const SATBackend& solv )
+{
+	warm_lits_.clear();
+	for( size_t tidx = 1; tidx < numTiles(); ++tidx ) {
+		for( size_t k = 1; k < var_stride_; ++k ) {
+			var_id v = tileVar( tidx, k );
+			if( (v != NO_VAR) && solv.value( v ) ) {
+				warm_lits_.push_back( pos( v ) );
+				break;
 			}
-			// std::cout << "Found solution with holes" << std::endl;
-			return true;
+		}
+	}
+}
+
+// A propagator that detects holes in the outer corona during search,
+// producing the same clauses as getHoleClauses(), with the same guard.
+template<typename grid>
+std::unique_ptr<HolePropagator<grid>> HeeschSolver<grid>::makeHolePropagator(
+	const std::vector<sat_lit>& guard ) const
+{
+	auto prop = std::make_unique<HolePropagator<grid>>( 
+		cell_pos_, cell_map_, guard );
+	size_t sz = shape_.size();
+
+	std::vector<cell_index> cells;
+	std::vector<var_id> vars;
+	std::vector<sat_lit> outer;
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		const cell_index *tcells = &tile_cells_[tidx * sz];
+		cells.assign( tcells, tcells + sz );
+
+		const var_id *tvars = &tile_vars_[tidx * var_stride_];
+		vars.clear();
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			if( tvars[k] != NO_VAR ) {
+				vars.push_back( tvars[k] );
+			}
+		}
+
+		outer.clear();
+		if( tileVar( tidx, level_ ) != NO_VAR ) {
+			excludeLevel( tidx, level_, outer );
+		}
+		prop->addTile( cells, vars, outer );
+	}
+
+	return prop;
+}
+
+// If the tiles used in the solver's model enclose any holes, produce a
+// clause for each hole that forbids it, with the guard literals 
+// appended, and return true.  The finder is brought up to date with the
+// model, so that it can be reused for the next one.
+template<typename grid>
+bool HeeschSolver<grid>::getHoleClauses( const SATBackend& solv,
+	const std::vector<sat_lit>& guard, HoleFinder<grid>& finder,
+	std::vector<std::vector<sat_lit>>& cls ) const
+{
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		if( tileUsed( solv, tidx ) ) {
+			finder.addCopy( tidx, tile_xforms_[tidx] );
 		} else {
-			// std::cout << "No solution with holes" << std::endl;
-			return false;
+			finder.removeCopy( tidx, tile_xforms_[tidx] );
 		}
-	} else {
+	}
+
+	// Only a core of the copies around each hole is needed to forbid it,
+	// and shorter clauses rule out many more patches.
+	std::vector<std::vector<tile_index>> holes;
+	if( !finder.getHoles( holes, true ) ) {
 		return false;
 	}
+
+	for( auto& hole : holes ) {
+		std::vector<sat_lit> cl;
+		// std::cout << "Forbidding a hole:";
+		for( auto& index : hole ) {
+			// We know that there's a variable at the top level,
+			// otherwise we wouldn't have found a hole in the
+			// first place.
+			excludeLevel( index, level_, cl );
+			// std::cout << " " << index;
+		}
+		// std::cout << std::endl;
+		cl.insert( cl.end(), guard.begin(), guard.end() );
+		cls.push_back( std::move( cl ) );
+	}
+	return true;
+}
+
+// Split the search for a corona into cubes, each given as a set of 
+// assumptions: a choice of the level-1 tiles covering the first 
+// cube_depth_ cells of the kernel's halo.  Every corona covers those
+// cells with level-1 tiles, so it satisfies exactly one cube.
+template<typename grid>
+void HeeschSolver<grid>::getCubes( 
+	std::vector<std::vector<sat_lit>>& cubes ) const
+{
+	size_t sz = shape_.size();
+
+	std::vector<cell_index> cells;
+	for( const auto& p : cloud_.halo_ ) {
+		if( cells.size() == cube_depth_ ) {
+			break;
+		}
+		auto i = cell_map_.find( p );
+		if( i != cell_map_.end() ) {
+			cells.push_back( i->second );
+		}
+	}
+
+	std::vector<tile_index> chosen;
+	std::vector<sat_lit> cube;
+
+	auto covers = [this, sz]( tile_index tidx, cell_index cidx ) {
+		const cell_index *row = &tile_cells_[tidx * sz];
+		return std::find( row, row + sz, cidx ) != row + sz;
+	};
+	auto overlaps = [this]( tile_index a, tile_index b ) {
+		const auto& ov = tile_overlaps_[a];
+		return std::find( ov.begin(), ov.end(), b ) != ov.end();
+	};
+
+	std::function<void( size_t )> split = [&]( size_t idx ) {
+		if( idx == cells.size() ) {
+			cubes.push_back( cube );
+			return;
+		}
+
+		cell_index cidx = cells[idx];
+		for( auto tidx : chosen ) {
+			if( covers( tidx, cidx ) ) {
+				split( idx + 1 );
+				return;
+			}
+		}
+
+		for( size_t k = cell_start_[cidx]; k < cell_start_[cidx+1]; ++k ) {
+			tile_index tidx = cell_tiles_[k];
+			var_id v = tileVar( tidx, 1 );
+			if( v == NO_VAR ) {
+				continue;
+			}
+			bool ok = true;
+			for( auto other : chosen ) {
+				if( overlaps( tidx, other ) ) {
+					ok = false;
+					break;
+				}
+			}
+			if( !ok ) {
+				continue;
+			}
+
+			chosen.push_back( tidx );
+			cube.push_back( pos( v ) );
+			split( idx + 1 );
+			chosen.pop_back();
+			cube.pop_back();
+		}
+	};
+
+	split( 0 );
+}
+
+// Solve the cubes on a pool of cube_threads_ threads, each with its own
+// copy of the clauses.  Hole-blocking clauses are valid in every cube, 
+// so they're shared between the threads.  As in hasCorona(), a solution
+// with holes is only reported if no cube has a hole-free one.
+template<typename grid>
+SATResult HeeschSolver<grid>::solveCubes( 
+	bool get_solution, bool& has_holes, Solution<coord_t>& soln )
+{
+	std::vector<std::vector<sat_lit>> cubes;
+	getCubes( cubes );
+
+	size_t num = std::min( cube_threads_, cubes.size() );
+	std::vector<std::unique_ptr<SATBackend>> solvers;
+	for( size_t idx = 0; idx < num; ++idx ) {
+		// Only the first thread records its clauses for -dumpcnf; the 
+		// dump is the whole problem, without any cube.
+		auto solver = makeSATBackend( backend_ );
+		if( (idx == 0) && !dump_prefix_.empty() ) {
+			solver = std::make_unique<RecordingBackend>( 
+				std::move( solver ) );
+		}
+		solver->newVars( next_var_ );
+		getClauses( *solver, false );
+		getSymmetryClauses( *solver, { neg( sym_sel_ ) } );
+		if( idx == 0 ) {
+			std::vector<sat_lit> assumps;
+			if( break_symmetry_ ) {
+				assumps.push_back( pos( sym_sel_ ) );
+			}
+			dumpCNF( *solver, assumps, "" );
+		}
+		solvers.push_back( std::move( solver ) );
+	}
+
+	std::mutex mutex;
+	std::atomic<size_t> next_cube { 0 };
+	std::atomic<size_t> running { num };
+	// Set once a hole-free corona has been found or a budget has run out.
+	std::atomic<bool> done { false };
+
+	std::vector<std::vector<sat_lit>> hole_clauses;
+	bool found = false;
+	bool found_holes = false;
+	bool out_of_budget = false;
+	Solution<coord_t> hole_soln;
+
+	auto work = [&]( SATBackend& solv ) {
+		size_t seen = 0;
+		HoleFinder<grid> finder { shape_, cell_pos_ };
+		std::vector<std::vector<sat_lit>> blocks;
+		std::vector<sat_lit> assumps;
+
+		while( !done ) {
+			size_t cidx = next_cube++;
+			if( cidx >= cubes.size() ) {
+				break;
+			}
+			assumps = cubes[cidx];
+			if( break_symmetry_ ) {
+				assumps.push_back( pos( sym_sel_ ) );
+			}
+
+			while( !done ) {
+				{
+					std::lock_guard<std::mutex> lock { mutex };
+					for( ; seen < hole_clauses.size(); ++seen ) {
+						solv.addClause( hole_clauses[seen] );
+					}
+				}
+
+				SATResult res = applyBudget( solv ) 
+					? solv.solve( assumps ) : SAT_UNKNOWN;
+				if( res == SAT_UNSATISFIABLE ) {
+					break;
+				}
+
+				std::lock_guard<std::mutex> lock { mutex };
+				if( res == SAT_UNKNOWN ) {
+					// Interrupted because another thread is done, or
+					// out of budget.
+					if( !done ) {
+						out_of_budget = true;
+						done = true;
+					}
+					break;
+				}
+
+				blocks.clear();
+				if( !getHoleClauses( solv, {}, finder, blocks ) ) {
+					if( !done ) {
+						found = true;
+						if( get_solution ) {
+							getSolution( solv, soln );
+						}
+						done = true;
+					}
+					break;
+				}
+
+				if( !found_holes ) {
+					found_holes = true;
+					if( get_solution ) {
+						getSolution( solv, hole_soln );
+					}
+				}
+				hole_clauses.insert( hole_clauses.end(), 
+					blocks.begin(), blocks.end() );
+			}
+		}
+
+		--running;
+	};
+
+	std::vector<std::thread> threads;
+	for( size_t idx = 0; idx < num; ++idx ) {
+		threads.emplace_back( work, std::ref( *solvers[idx] ) );
+	}
+
+	// An interruption is lost if it arrives before a query starts, so 
+	// keep repeating it until all threads have stopped.
+	while( running > 0 ) {
+		if( done ) {
+			for( auto& solver : solvers ) {
+				solver->interrupt();
+			}
+		}
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	}
+	for( auto& t : threads ) {
+		t.join();
+	}
+
+	if( found ) {
+		has_holes = false;
+		return SAT_SATISFIABLE;
+	} else if( out_of_budget ) {
+		timed_out_ = true;
+		return SAT_UNKNOWN;
+	} else if( found_holes ) {
+		has_holes = true;
+		if( get_solution ) {
+			soln = hole_soln;
+		}
+		return SAT_SATISFIABLE;
+	} else {
+		return SAT_UNSATISFIABLE;
+	}
+}
+
+// A solver for hasCorona(), racing several instances of the backend
+// if portfolio mode is on.
+template<typename grid>
+std::unique_ptr<SATBackend> HeeschSolver<grid>::makeSolver() const
+{
+	std::unique_ptr<SATBackend> ret;
+	if( portfolio_size_ > 1 ) {
+		ret = std::make_unique<PortfolioBackend>( backend_, 
+			portfolio_size_, portfolio_clauses_, portfolio_time_ );
+	} else {
+		ret = makeSATBackend( backend_ );
+	}
+
+	if( !dump_prefix_.empty() ) {
+		ret = std::make_unique<RecordingBackend>( std::move( ret ) );
+	}
+	return ret;
+}
+
+// If solv is recording its clauses, write them out together with the
+// variable map (see setDumpCNF()).  Each tile line of the map gives the
+// tile's transform followed by its variable at each level, with 0 for 
+// none; each cell line gives a cell's variable and coordinates.
+template<typename grid>
+void HeeschSolver<grid>::dumpCNF( const SATBackend& solv,
+	const std::vector<sat_lit>& assumps, const std::string& suffix ) const
+{
+	const RecordingBackend *rec = dynamic_cast<const RecordingBackend*>( &solv );
+	if( rec == nullptr ) {
+		return;
+	}
+
+	std::string stem = dump_prefix_ + "_" + std::to_string( level_ ) + suffix;
+
+	std::ofstream cnf { stem + ".cnf" };
+	cnf << "c heesch-sat corona problem, level " << level_ << '\n';
+	rec->writeDIMACS( cnf, assumps );
+
+	// Start with the shape as a naked tile record, so that tools can
+	// read it with TileInfo.
+	std::ofstream map { stem + ".map" };
+	map << gridTypeAbbreviation( grid::grid_type ) << '?';
+	for( const auto& p : shape_ ) {
+		map << ' ' << p.x_ << ' ' << p.y_;
+	}
+	map << '\n';
+
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		const xform_t& T = tile_xforms_[tidx];
+		map << "t " << T.a_ << ' ' << T.b_ << ' ' << T.c_ << ' ' 
+			<< T.d_ << ' ' << T.e_ << ' ' << T.f_;
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			var_id v = tileVar( tidx, k );
+			map << ' ' << ((v == NO_VAR) ? 0 : pos( v ));
+		}
+		map << '\n';
+	}
+	for( size_t cidx = 0; cidx < cell_pos_.size(); ++cidx ) {
+		if( cell_vars_[cidx] != NO_VAR ) {
+			map << "c " << pos( cell_vars_[cidx] ) << ' ' 
+				<< cell_pos_[cidx].x_ << ' ' << cell_pos_[cidx].y_ << '\n';
+		}
+	}
+}
+
+// Set the limits for the next query to solv, or return false if the
+// time allowed for this shape has already run out.
+template<typename grid>
+bool HeeschSolver<grid>::applyBudget( SATBackend& solv ) const
+{
+	double seconds = call_seconds_;
+	if( shape_seconds_ > 0.0 ) {
+		double left = shape_seconds_ - std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start_time_ ).count();
+		if( left <= 0.0 ) {
+			return false;
+		}
+		if( (seconds == 0.0) || (left < seconds) ) {
+			seconds = left;
+		}
+	}
+
+	solv.setTimeBudget( seconds );
+	solv.setConflictBudget( call_conflicts_ );
+	return true;
+}
+
+template<typename grid>
+SATResult HeeschSolver<grid>::solveWithinBudget( 
+	SATBackend& solv, const std::vector<sat_lit>& assumps )
+{
+	SATResult res = applyBudget( solv ) ? solv.solve( assumps ) : SAT_UNKNOWN;
+	if( res == SAT_UNKNOWN ) {
+		timed_out_ = true;
+	}
+	return res;
+}
+
+// Get the persistent solver for incremental mode, bringing it up to
+// date with the current level if necessary.  Only the clauses that 
+// involve variables created since the last call are generated, together 
+// with the level-dependent families.  Clauses that depend on the
+// outer level are guarded by a new activation variable, returned in
+// act, which must be assumed true when solving.  The guarded clauses of
+// the previous level are retired permanently.
+template<typename grid>
+SATBackend& HeeschSolver<grid>::getIncrementalSolver( var_id& act )
+{
+	if( !solver_ ) {
+		solver_ = makeSolver();
+	}
+
+	if( solver_level_ != level_ ) {
+		if( solver_level_ > 0 ) {
+			solver_->addClause( { neg( level_act_ ) } );
+		}
+
+		solver_level_ = level_;
+		level_act_ = declareVariable();
+		solver_->newVars( next_var_ - solver_->numVars() );
+		std::vector<sat_lit> guard { neg( level_act_ ) };
+		if( check_hh_ ) {
+			guard.push_back( pos( hole_sel_ ) );
+		}
+		getClauses( *solver_, false, guard, encoded_var_, encoded_level_ );
+		getSymmetryClauses( *solver_, 
+			{ neg( level_act_ ), neg( sym_sel_ ) } );
+
+		encoded_var_ = next_var_;
+		encoded_level_ = level_;
+		fresh_tiles_.clear();
+	}
+
+	act = level_act_;
+	return *solver_;
 }
 
 #if 0
@@ -745,7 +2265,7 @@ bool HeeschSolver<grid>::isSurroundIsohedral(
 // includes extra checks.  Keep it around for a while to cross-check 
 // new implementations.
 template<typename grid>
-bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv ) 
+bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( SATBackend& solv ) 
 {
 	// std::cerr << "Checking isohedral..." << std::endl;
 
@@ -753,9 +2273,9 @@ bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv
 	// 1-corona.  Augment it with new clauses that restrict solutions 
 	// to patches that witness isohedral tilings.
 
-	std::vector<CMSat::Lit> ucl { 1 };
-	std::vector<CMSat::Lit> bcl { 2 };
-	std::vector<CMSat::Lit> tcl { 3 };
+	std::vector<sat_lit> ucl( 1 );
+	std::vector<sat_lit> bcl( 2 );
+	std::vector<sat_lit> tcl( 3 );
 
 	// size_t joint_clauses = 0;
 
@@ -774,7 +2294,7 @@ bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv
 
 				bcl[0] = neg( t_id );
 				bcl[1] = pos( ti_id );
-				solv.add_clause( bcl );
+				solv.addClause( bcl );
 			} else {
 				// This shouldn't be possible.  If T is adajcent to the
 				// kernel, then T^-1 must be too.
@@ -782,7 +2302,7 @@ bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv
 				// T isn't involutory, but its inverse isn't an adjacent.
 				// Therefore, T can't be used!
 				ucl[0] = neg( t_id );
-				solv.add_clause( ucl );
+				solv.addClause( ucl );
 				continue;
 			}
 		}
@@ -812,10 +2332,10 @@ bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv
 
 	bool orig = tiles_isohedrally_;
 
-	CMSat::SATSolver osolv;
-	osolv.new_vars( next_var_ );
-	getClauses( osolv, false );
-	if( orig != checkIsohedralTilingV2( osolv ) ) {
+	auto osolv = makeSATBackend( backend_ );
+	osolv->newVars( next_var_ );
+	getClauses( *osolv, false );
+	if( orig != checkIsohedralTilingV2( *osolv ) ) {
 		std::cerr << "Computations don't match!" << std::endl;
 		tiles_isohedrally_ = orig;
 	}
@@ -824,21 +2344,38 @@ bool HeeschSolver<grid>::checkIsohedralTiling_deprecated( CMSat::SATSolver& solv
 #endif
 
 template<typename grid>
-bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv ) 
+bool HeeschSolver<grid>::checkIsohedralTiling( 
+	SATBackend& solv, const std::vector<sat_lit>& assumps ) 
 {
 	// The solver is assumed to contain the clauses for a hole-free
-	// 1-corona.  Augment it with new clauses that restrict solutions 
-	// to patches that witness isohedral tilings.
+	// 1-corona, under the given assumptions.  Augment it with new 
+	// clauses that restrict solutions to patches that witness isohedral 
+	// tilings.  They're all guarded by a new selector, which is retired
+	// at the end, so the solver can go on to the next level.  The 
+	// enumeration below renews the budget before each solve; if the 
+	// shape's time is already gone, don't bother building the clauses.
+	if( !applyBudget( solv ) ) {
+		timed_out_ = true;
+		return false;
+	}
 
-	std::vector<CMSat::Lit> ucl { 1 };
-	std::vector<CMSat::Lit> bcl { 2 };
-	std::vector<CMSat::Lit> tcl { 3 };
+	var_id sel = declareVariable();
+	solv.newVars( next_var_ - solv.numVars() );
+	std::vector<sat_lit> iso_assumps { assumps };
+	iso_assumps.push_back( pos( sel ) );
+
+	std::vector<sat_lit> bcl( 3 );
+	std::vector<sat_lit> tcl( 4 );
+	bcl[2] = neg( sel );
+	tcl[3] = neg( sel );
 
 	for( const auto& T : cloud_.adjacent_ ) {
 		xform_t Ti = T.invert();
 		var_id t_id;
 
-		getShapeVariable( T, 1, t_id );
+		if( !getShapeVariable( T, 1, t_id ) ) {
+			continue;
+		}
 
 		// This should not be used for involutory transforms
 		if( T != Ti ) {
@@ -854,11 +2391,11 @@ bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv )
 				// an isohedral surround.
 				bcl[0] = neg( t_id );
 				bcl[1] = neg( t_id );
-				solv.add_clause( bcl );
+				solv.addClause( bcl );
 			} else {
 				bcl[0] = neg( t_id );
 				bcl[1] = pos( ti_id );
-				solv.add_clause( bcl );
+				solv.addClause( bcl );
 			}
 		}
 
@@ -876,7 +2413,9 @@ bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv )
 			}
 
 			var_id s_id;
-			getShapeVariable( S, 1, s_id );
+			if( !getShapeVariable( S, 1, s_id ) ) {
+				continue;
+			}
 
 			// This will create redundant clauses when T and S swap places,
 			// no?
@@ -887,7 +2426,7 @@ bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv )
 					tcl[0] = neg( s_id );
 					tcl[1] = neg( t_id );
 					tcl[2] = pos( a_id );
-					solv.add_clause( tcl );
+					solv.addClause( tcl );
 				}
 			}
 		}
@@ -895,6 +2434,7 @@ bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv )
 
 	// FIXME -- is there a reason to use allCoronas here and not something
 	// simpler?
+	bool interrupted = false;
 	allCoronas( solv, [this] ( const Solution<coord_t>& soln ) {
 		tiles_isohedrally_ = true;
 		/*
@@ -903,67 +2443,267 @@ bool HeeschSolver<grid>::checkIsohedralTiling( CMSat::SATSolver& solv )
 		}
 		*/
 		return false;
-	} );
+	}, iso_assumps, &interrupted );
+	solv.addClause( { neg( sel ) } );
+
+	// If the search ran out of budget, the tile may yet be isohedral,
+	// so report a timeout rather than a non-isohedral tile.
+	if( interrupted && !tiles_isohedrally_ ) {
+		timed_out_ = true;
+	}
 
 	return tiles_isohedrally_;
 }
 
-// Note that this enumerates only hole-free coronas.
+// Note that this enumerates only hole-free coronas.  Every solve is
+// made under the given assumptions.  If given, interrupted is set when 
+// the enumeration stops because the solver ran out of budget.
 template<typename grid>
-size_t HeeschSolver<grid>::allCoronas( 
-	CMSat::SATSolver& solv, solution_cb<coord_t> cb ) const
+size_t HeeschSolver<grid>::allCoronas( SATBackend& solv, 
+	solution_cb<coord_t> cb, const std::vector<sat_lit>& assumps,
+	bool *interrupted ) const
 {
-	size_t solutions = 0;
-
-	while( solv.solve() == CMSat::l_True ) {
-		// Got a solution, but it may have large holes.  Need to find
-		// them and iterate until they're gone.
+	Solution<coord_t> soln;
+	return enumerateCoronas( solv, 
+		[this, &cb, &soln]( const SATBackend& s, size_t ) {
+			getSolution( s, soln );
+			return cb( soln );
+		}, assumps, interrupted );
+}
 
-		HoleFinder<grid> finder { shape_ };
+// Enumerate models projected onto the tile variables, without blocking
+// clauses, which would pile up by the million for shapes with many 
+// surrounds and slow every later solve.  Instead, the search walks a
+// tree of assumptions and backtracks chronologically.  Given a model,
+// let t1, ..., tm be its true tile variables that aren't assumed yet.
+// The models still to be found either make all of them true, or make
+// t1, ..., ti-1 true and ti false for some i; those are the m children 
+// of the model, each solved under the assumptions extended accordingly.
+// A model that makes all of t1, ..., tm true and others besides would 
+// contain this corona within a larger one; those aren't reported.
+// Coronas with holes are simply skipped, since no model is visited 
+// twice.  The budget is renewed before every solve, so that the time
+// left for the shape bounds the whole enumeration, not each call.
+template<typename grid>
+size_t HeeschSolver<grid>::enumerateCoronas( SATBackend& solv, 
+	const corona_cb& cb, const std::vector<sat_lit>& assumps, 
+	bool *interrupted ) const
+{
+	// A model whose children are still to be visited: the length of
+	// the assumptions it was found under, its fresh true literals, and
+	// the next child.
+	struct Branch
+	{
+		size_t base;
+		std::vector<sat_lit> fresh;
+		size_t next;
+	};
 
-		std::vector<CMSat::Lit> cl;
-		const std::vector<CMSat::lbool>& model = solv.get_model();
+	size_t solutions = 0;
+	HoleFinder<grid> finder { shape_, cell_pos_ };
+	std::vector<sat_lit> cube { assumps };
+	std::vector<bool> assumed( solv.numVars(), false );
+	for( auto lit : assumps ) {
+		if( lit > 0 ) {
+			assumed[litVar( lit )] = true;
+		}
+	}
+	std::vector<Branch> branches;
+	std::vector<std::vector<tile_index>> holes;
+
+	auto solve = [this, &solv, &cube]() {
+		return applyBudget( solv ) ? solv.solve( cube ) : SAT_UNKNOWN;
+	};
+
+	SATResult res = solve();
+	while( res != SAT_UNKNOWN ) {
+		if( res == SAT_SATISFIABLE ) {
+			Branch br { cube.size(), {}, 0 };
+			size_t used_tiles = 0;
+
+			for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+				const var_id *vars = &tile_vars_[tidx * var_stride_];
+				bool used = false;
+				for( size_t k = 0; k < var_stride_; ++k ) {
+					if( (vars[k] != NO_VAR) && solv.value( vars[k] ) ) {
+						used = true;
+						if( !assumed[vars[k]] ) {
+							br.fresh.push_back( pos( vars[k] ) );
+						}
+					}
+				}
+				if( used ) {
+					++used_tiles;
+					finder.addCopy( tidx, tile_xforms_[tidx] );
+				} else {
+					finder.removeCopy( tidx, tile_xforms_[tidx] );
+				}
+			}
 
-		// Get tile info for hole detection, while simultaneously
-		// building clause for forbidding this solution.
-		for( auto& ti : tiles_ ) {
-			for( auto& i : ti.vars_ ) {
-				if( model[i.second] == CMSat::l_True ) {
-					finder.addCopy( ti.index_, ti.T_ );
-					cl.push_back( neg( i.second ) );
+			if( !finder.getHoles( holes ) ) {
+				++solutions;
+				if( !cb( solv, used_tiles ) ) {
+					return solutions;
 				}
 			}
+			branches.push_back( std::move( br ) );
+		}
+
+		// Move on to the next child of the deepest model that has one.
+		while( !branches.empty() 
+				&& (branches.back().next == branches.back().fresh.size()) ) {
+			branches.pop_back();
+		}
+		if( branches.empty() ) {
+			break;
 		}
 
-		std::vector<std::vector<tile_index>> holes;
-		if( !finder.getHoles( holes ) ) {
-			// No holes, so keep the solution
-			++solutions;
-			Solution<coord_t> soln;
-			getSolution( solv, soln );
-			if( !cb( soln ) ) {
-				return solutions;
+		Branch& br = branches.back();
+		while( cube.size() > br.base ) {
+			if( cube.back() > 0 ) {
+				assumed[litVar( cube.back() )] = false;
 			}
+			cube.pop_back();
 		}
+		for( size_t idx = 0; idx < br.next; ++idx ) {
+			assumed[litVar( br.fresh[idx] )] = true;
+			cube.push_back( br.fresh[idx] );
+		}
+		cube.push_back( -br.fresh[br.next] );
+		++br.next;
 
-		// Suppress this solution and keep going.
-		solv.add_clause( cl );
+		res = solve();
 	}
 
+	if( interrupted ) {
+		*interrupted = (res == SAT_UNKNOWN);
+	}
 	return solutions;
 }
+
 template<typename grid>
-void HeeschSolver<grid>::allCoronas( solution_cb<coord_t> cb ) const
+void HeeschSolver<grid>::enumerateCoronas( const corona_cb& cb ) const
 {
 	if( !cloud_.surroundable_ ) {
 		return;
 	}
+	if( cube_threads_ > 0 ) {
+		enumerateCubes( cb );
+		return;
+	}
+
+	std::unique_ptr<HolePropagator<grid>> prop;
+	std::unique_ptr<SATBackend> solver = makeSATBackend( backend_ );
+	if( !dump_prefix_.empty() ) {
+		solver = std::make_unique<RecordingBackend>( std::move( solver ) );
+	}
+	solver->newVars( next_var_ );
+	getClauses( *solver, false );
+	dumpCNF( *solver, {}, "all" );
+	if( hole_propagation_ ) {
+		prop = makeHolePropagator( {} );
+		solver->setPropagator( prop.get() );
+	}
+
+	enumerateCoronas( *solver, cb, {}, nullptr );
+}
+
+// Enumerate the coronas cube by cube (see getCubes()) on a pool of 
+// cube_threads_ threads, each with its own solver.  Every corona
+// satisfies exactly one cube, so the threads never find the same one
+// twice.  The callback is made under a lock, and once it asks to stop,
+// the other threads are interrupted.
+template<typename grid>
+void HeeschSolver<grid>::enumerateCubes( const corona_cb& cb ) const
+{
+	std::vector<std::vector<sat_lit>> cubes;
+	getCubes( cubes );
+
+	size_t num = std::min( cube_threads_, cubes.size() );
+	std::vector<std::unique_ptr<SATBackend>> solvers;
+	std::vector<std::unique_ptr<HolePropagator<grid>>> props;
+	for( size_t idx = 0; idx < num; ++idx ) {
+		auto solver = makeSATBackend( backend_ );
+		if( (idx == 0) && !dump_prefix_.empty() ) {
+			solver = std::make_unique<RecordingBackend>( 
+				std::move( solver ) );
+		}
+		solver->newVars( next_var_ );
+		getClauses( *solver, false );
+		if( idx == 0 ) {
+			dumpCNF( *solver, {}, "all" );
+		}
+		if( hole_propagation_ ) {
+			props.push_back( makeHolePropagator( {} ) );
+			solver->setPropagator( props.back().get() );
+		}
+		solvers.push_back( std::move( solver ) );
+	}
 
-	CMSat::SATSolver solver;
-	solver.new_vars( next_var_ );
-	getClauses( solver, false );
+	std::mutex mutex;
+	std::atomic<size_t> next_cube { 0 };
+	std::atomic<size_t> running { num };
+	// Set once the callback has asked to stop.
+	std::atomic<bool> done { false };
 
-	allCoronas( solver, cb );
+	corona_cb report = [&]( const SATBackend& solv, size_t tiles ) {
+		std::lock_guard<std::mutex> lock { mutex };
+		if( done ) {
+			return false;
+		}
+		if( !cb( solv, tiles ) ) {
+			done = true;
+		}
+		return !done;
+	};
+
+	auto work = [&]( SATBackend& solv ) {
+		while( !done ) {
+			size_t cidx = next_cube++;
+			if( cidx >= cubes.size() ) {
+				break;
+			}
+			enumerateCoronas( solv, report, cubes[cidx], nullptr );
+		}
+		--running;
+	};
+
+	std::vector<std::thread> threads;
+	for( size_t idx = 0; idx < num; ++idx ) {
+		threads.emplace_back( work, std::ref( *solvers[idx] ) );
+	}
+
+	// As in solveCubes(), keep repeating the interruption until all
+	// threads have stopped.
+	while( running > 0 ) {
+		if( done ) {
+			for( auto& solver : solvers ) {
+				solver->interrupt();
+			}
+		}
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	}
+	for( auto& t : threads ) {
+		t.join();
+	}
+}
+
+template<typename grid>
+void HeeschSolver<grid>::allCoronas( solution_cb<coord_t> cb ) const
+{
+	Solution<coord_t> soln;
+	enumerateCoronas( [this, &cb, &soln]( const SATBackend& s, size_t ) {
+		getSolution( s, soln );
+		return cb( soln );
+	} );
+}
+
+template<typename grid>
+void HeeschSolver<grid>::countCoronas( count_cb cb ) const
+{
+	enumerateCoronas( [&cb]( const SATBackend&, size_t num ) {
+		return cb( num );
+	} );
 }
 
 template<typename grid>
@@ -977,31 +2717,37 @@ void HeeschSolver<grid>::allCoronas( std::vector<Solution<coord_t>>& solns )
 template<typename grid>
 void HeeschSolver<grid>::debug( std::ostream& os ) const
 {
-	for( auto& ci : cells_ ) {
-		os << "  Cell #" << ci.index_ << " at " << ci.pos_ 
-		   << ", var = " << ci.var_ << std::endl;
+	size_t sz = shape_.size();
+
+	for( size_t cidx = 0; cidx < cell_pos_.size(); ++cidx ) {
+		os << "  Cell #" << cidx << " at " << cell_pos_[cidx] 
+		   << ", var = " << cell_vars_[cidx] << std::endl;
 		os << "    Tiles:";
-		for( auto& index: ci.tiles_ ) {
-			os << " " << index;
+		for( size_t idx = cell_start_[cidx]; idx < cell_start_[cidx+1]; ++idx ) {
+			os << " " << cell_tiles_[idx];
 		}
 		os << std::endl;
 	}
-	for( auto& ti : tiles_ ) {
-		os << "  Tile #" << ti.index_ << " at " << ti.T_ << ":" << std::endl;
+	for( size_t tidx = 0; tidx < numTiles(); ++tidx ) {
+		const xform_t& T = tile_xforms_[tidx];
+		os << "  Tile #" << tidx << " at " << T << ":" << std::endl;
 		os << "    Cells:";
-		for( auto& i : ti.cells_ ) {
-			os << " " << i << ":" << cells_[i].pos_;
+		for( size_t idx = 0; idx < sz; ++idx ) {
+			cell_index cidx = tile_cells_[tidx * sz + idx];
+			os << " " << cidx << ":" << cell_pos_[cidx];
 		}
 		os << std::endl;
 		os << "    Halo:";
 		for( auto& p : cloud_.halo_ ) {
-			auto hp = ti.T_ * p;
+			auto hp = T * p;
 			os << " " << hp ;
 		}	
 		os << std::endl;
 		os << "    Vars:";
-		for( auto i : ti.vars_ ) {
-			os << " [" << i.first << "," << i.second << "]";
+		for( size_t k = 0; k < var_stride_; ++k ) {
+			if( tileVar( tidx, k ) != NO_VAR ) {
+				os << " [" << k << "," << tileVar( tidx, k ) << "]";
+			}
 		}
 		os << std::endl;
 	}
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "grid.h"
+#include "satbackend.h"
+
+// Detect holes in the outer corona while the SAT solver is still
+// searching, rather than in complete models.  A connected region of
+// empty cells that is enclosed by copies of the shape, all of them used
+// in the outer corona, can never be filled: a copy placed inside it
+// would have no path of adjacent copies back to the kernel through
+// coronas of decreasing level.  So such a region is already a hole, and
+// the outer copies around it can't all be used together.  That's the
+// same clause that the hole-finding loop in HeeschSolver::hasCorona()
+// would learn from a complete model, but it's found much earlier.
+//
+// Cells are indexed as in HeeschSolver.  A region that reaches a cell
+// that no copy can cover is treated as unenclosed, which errs on the
+// safe side.
+template<typename grid>
+class HolePropagator
+	: public SATPropagator
+{
+public:
+	using coord_t = typename grid::coord_t;
+	using point_t = typename grid::point_t;
+
+	HolePropagator( const std::vector<point_t>& cells,
+		const point_map<coord_t,cell_index>& cell_map,
+		const std::vector<sat_lit>& guard );
+
+	// Add a copy of the shape covering the given cells, with variables
+	// vars (true if it's used at all).  Its outer literals are all false
+	// exactly when it's used in the outer corona; a copy that can't be
+	// used there has none.  The first copy added must be the kernel.
+	void addTile( const std::vector<cell_index>& cells,
+		const std::vector<var_id>& vars,
+		const std::vector<sat_lit>& outer );
+
+	const std::vector<var_id>& observedVars() const override
+	{
+		return observed_;
+	}
+	void assign( sat_lit l ) override;
+	void newLevel() override
+	{
+		level_starts_.push_back( trail_.size() );
+	}
+	void backtrack( size_t level ) override;
+	bool getClause( std::vector<sat_lit>& cl ) override;
+
+private:
+	void use( tile_index tidx, int delta );
+	bool search( cell_index start, std::vector<sat_lit>& cl );
+
+	// For every cell, its edge neighbours and its neighbours of any
+	// kind, in compressed rows, with -1 for a cell that no copy can 
+	// cover.
+	std::vector<size_t> edge_start_;
+	std::vector<cell_index> edge_nbrs_;
+	std::vector<size_t> nbr_start_;
+	std::vector<cell_index> nbrs_;
+
+	std::vector<sat_lit> guard_;
+	std::vector<var_id> observed_;
+
+	std::vector<std::vector<cell_index>> tile_cells_;
+	std::vector<std::vector<sat_lit>> tile_outer_;
+	// Per variable: its tile, its literal among the tile's outer
+	// literals (0 if none), and its current value (0 if unassigned).
+	std::unordered_map<var_id,tile_index> var_tile_;
+	std::unordered_map<var_id,sat_lit> var_outer_;
+	std::unordered_map<var_id,sat_lit> values_;
+
+	// Per tile: the number of its variables that are true, and of its
+	// outer literals that are false.
+	std::vector<size_t> num_true_;
+	std::vector<size_t> num_false_;
+
+	// Per cell: the number of used tiles covering it, and the xor of
+	// their indices, which is the tile itself if there's only one.
+	// Cells covered twice make the assignment inconsistent anyway, so
+	// there's no search until the overlap is undone.
+	std::vector<size_t> cover_;
+	std::vector<tile_index> owner_;
+	size_t overlaps_;
+
+	// The assigned literals, and where each decision level starts.
+	std::vector<sat_lit> trail_;
+	std::vector<size_t> level_starts_;
+
+	// Set when the covered cells or the outer tiles grow.
+	bool dirty_;
+
+	// Cells visited by the current check, and by the current search
+	// within it, which also marks the tiles found around the region.
+	std::vector<size_t> seen_;
+	size_t stamp_;
+	std::vector<size_t> in_region_;
+	std::vector<size_t> tile_seen_;
+	size_t search_;
+	std::vector<cell_index> stack_;
+	std::vector<cell_index> region_;
+	std::vector<tile_index> owners_;
+};
+
+template<typename grid>
+HolePropagator<grid>::HolePropagator( const std::vector<point_t>& cells,
+	const point_map<coord_t,cell_index>& cell_map,
+	const std::vector<sat_lit>& guard )
+	: edge_start_ {}
+	, edge_nbrs_ {}
+	, nbr_start_ {}
+	, nbrs_ {}
+	, guard_ { guard }
+	, observed_ {}
+	, tile_cells_ {}
+	, tile_outer_ {}
+	, var_tile_ {}
+	, var_outer_ {}
+	, values_ {}
+	, num_true_ {}
+	, num_false_ {}
+	, cover_( cells.size(), 0 )
+	, owner_( cells.size(), 0 )
+	, overlaps_ { 0 }
+	, trail_ {}
+	, level_starts_ {}
+	, dirty_ { false }
+	, seen_( cells.size(), 0 )
+	, stamp_ { 0 }
+	, in_region_( cells.size(), 0 )
+	, tile_seen_ {}
+	, search_ { 0 }
+	, stack_ {}
+	, region_ {}
+	, owners_ {}
+{
+	for( const auto& p : cells ) {
+		edge_start_.push_back( edge_nbrs_.size() );
+		for( auto pn : edge_neighbours<grid> { p } ) {
+			auto i = cell_map.find( pn );
+			edge_nbrs_.push_back( (i == cell_map.end()) ? -1 : i->second );
+		}
+		nbr_start_.push_back( nbrs_.size() );
+		for( auto pn : neighbours<grid> { p } ) {
+			auto i = cell_map.find( pn );
+			nbrs_.push_back( (i == cell_map.end()) ? -1 : i->second );
+		}
+	}
+	edge_start_.push_back( edge_nbrs_.size() );
+	nbr_start_.push_back( nbrs_.size() );
+}
+
+template<typename grid>
+void HolePropagator<grid>::addTile( const std::vector<cell_index>& cells,
+	const std::vector<var_id>& vars, const std::vector<sat_lit>& outer )
+{
+	tile_index tidx = tile_cells_.size();
+	tile_cells_.push_back( cells );
+	tile_outer_.push_back( outer );
+	num_true_.push_back( 0 );
+	num_false_.push_back( 0 );
+	tile_seen_.push_back( 0 );
+
+	for( auto v : vars ) {
+		observed_.push_back( v );
+		var_tile_[v] = tidx;
+		values_[v] = 0;
+	}
+	for( auto l : outer ) {
+		var_outer_[litVar( l )] = l;
+	}
+}
+
+template<typename grid>
+void HolePropagator<grid>::use( tile_index tidx, int delta )
+{
+	for( auto cidx : tile_cells_[tidx] ) {
+		owner_[cidx] ^= tidx;
+		if( delta > 0 ) {
+			if( cover_[cidx]++ > 0 ) {
+				++overlaps_;
+			}
+		} else if( --cover_[cidx] > 0 ) {
+			--overlaps_;
+		}
+	}
+}
+
+template<typename grid>
+void HolePropagator<grid>::assign( sat_lit l )
+{
+	var_id v = litVar( l );
+	auto i = values_.find( v );
+	if( (i == values_.end()) || (i->second == l) ) {
+		// Not ours, or heard about before.
+		return;
+	}
+	i->second = l;
+	trail_.push_back( l );
+
+	tile_index tidx = var_tile_[v];
+	if( (l > 0) && (num_true_[tidx]++ == 0) ) {
+		use( tidx, 1 );
+		dirty_ = true;
+	}
+	auto j = var_outer_.find( v );
+	if( (j != var_outer_.end()) && (j->second == -l) ) {
+		if( ++num_false_[tidx] == tile_outer_[tidx].size() ) {
+			dirty_ = true;
+		}
+	}
+}
+
+template<typename grid>
+void HolePropagator<grid>::backtrack( size_t level )
+{
+	if( level >= level_starts_.size() ) {
+		return;
+	}
+
+	size_t keep = level_starts_[level];
+	level_starts_.resize( level );
+	while( trail_.size() > keep ) {
+		sat_lit l = trail_.back();
+		trail_.pop_back();
+
+		var_id v = litVar( l );
+		values_[v] = 0;
+		tile_index tidx = var_tile_[v];
+		if( (l > 0) && (--num_true_[tidx] == 0) ) {
+			use( tidx, -1 );
+		}
+		auto j = var_outer_.find( v );
+		if( (j != var_outer_.end()) && (j->second == -l) ) {
+			--num_false_[tidx];
+		}
+	}
+}
+
+template<typename grid>
+bool HolePropagator<grid>::getClause( std::vector<sat_lit>& cl )
+{
+	// Nothing can be enclosed until the kernel is in place.
+	if( !dirty_ || (overlaps_ > 0) || (num_true_[0] == 0) ) {
+		return false;
+	}
+	dirty_ = false;
+
+	// Look at the empty cells next to the copies used in the outer
+	// corona.  Any hole must include one of them.
+	++stamp_;
+	for( auto l : trail_ ) {
+		if( l < 0 ) {
+			continue;
+		}
+		tile_index tidx = var_tile_[litVar( l )];
+		if( tile_outer_[tidx].empty()
+				|| (num_false_[tidx] < tile_outer_[tidx].size()) ) {
+			continue;
+		}
+		for( auto cidx : tile_cells_[tidx] ) {
+			for( size_t idx = edge_start_[cidx];
+					idx < edge_start_[cidx+1]; ++idx ) {
+				cell_index nidx = edge_nbrs_[idx];
+				if( (nidx >= 0) && (cover_[nidx] == 0)
+						&& (seen_[nidx] != stamp_) && search( nidx, cl ) ) {
+					// Leave the rest for the next call.
+					dirty_ = true;
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+// Flood-fill the region of empty cells containing start.  If it's
+// enclosed by outer tiles, forbid them from being used together.  The
+// region must be bounded by covered cells even diagonally; otherwise a
+// copy inside it could touch one outside it at a corner.
+template<typename grid>
+bool HolePropagator<grid>::search( cell_index start, std::vector<sat_lit>& cl )
+{
+	++search_;
+	region_.clear();
+	stack_.clear();
+	stack_.push_back( start );
+	seen_[start] = stamp_;
+	in_region_[start] = search_;
+
+	bool enclosed = true;
+	while( !stack_.empty() ) {
+		cell_index cidx = stack_.back();
+		stack_.pop_back();
+		region_.push_back( cidx );
+
+		for( size_t idx = edge_start_[cidx]; idx < edge_start_[cidx+1]; ++idx ) {
+			cell_index nidx = edge_nbrs_[idx];
+			if( nidx < 0 ) {
+				enclosed = false;
+			} else if( (cover_[nidx] == 0) && (in_region_[nidx] != search_) ) {
+				seen_[nidx] = stamp_;
+				in_region_[nidx] = search_;
+				stack_.push_back( nidx );
+			}
+		}
+	}
+	if( !enclosed ) {
+		return false;
+	}
+
+	owners_.clear();
+	for( auto cidx : region_ ) {
+		for( size_t idx = nbr_start_[cidx]; idx < nbr_start_[cidx+1]; ++idx ) {
+			cell_index nidx = nbrs_[idx];
+			if( nidx < 0 ) {
+				return false;
+			} else if( cover_[nidx] == 0 ) {
+				if( in_region_[nidx] != search_ ) {
+					return false;
+				}
+				continue;
+			}
+
+			tile_index tidx = owner_[nidx];
+			if( tile_outer_[tidx].empty()
+					|| (num_false_[tidx] < tile_outer_[tidx].size()) ) {
+				// A border tile that isn't known to be in the outer
+				// corona.  Maybe the region will be filled.
+				return false;
+			} else if( tile_seen_[tidx] != search_ ) {
+				tile_seen_[tidx] = search_;
+				owners_.push_back( tidx );
+			}
+		}
+	}
+
+	cl.clear();
+	for( auto tidx : owners_ ) {
+		cl.insert( cl.end(), tile_outer_[tidx].begin(), tile_outer_[tidx].end() );
+	}
+	cl.insert( cl.end(), guard_.begin(), guard_.end() );
+	return true;
+}
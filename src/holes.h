@@ -1,12 +1,21 @@
 #pragma once
 
 #include <vector>
-#include <stack>
-#include <unordered_set>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
 
 #include "grid.h"
 #include "shape.h"
 
+// Find holes in a patch made of copies of a shape.  The patch lives in a
+// dense grid of bits covering a fixed region of the plane, with one bit
+// per cell position, stored in rows of 64-bit words.  Copies can be added
+// and removed, and the finder keeps track of the covered cells and the
+// halo around them as it goes, so reusing a finder for a sequence of
+// similar patches costs time proportional to the differences between
+// them.  Flood fills are carried out a row of words at a time.
 template<typename grid>
 class HoleFinder
 {
@@ -15,130 +24,546 @@ public:
 	using point_t = typename grid::point_t;
 	using xform_t = typename grid::xform_t;
 
-	HoleFinder( const Shape<grid>& shape );
+	// Every copy must lie within the given cells.
+	HoleFinder( const Shape<grid>& shape, const std::vector<point_t>& cells );
+
+	// Adding a copy that's already present, or removing one that isn't,
+	// does nothing.
 	void addCopy( tile_index idx, const xform_t& T );
-	bool getHoles( std::vector<std::vector<tile_index>>& holes );
+	void removeCopy( tile_index idx, const xform_t& T );
+
+	// Produce the copies around each hole.  If minimal is set, pare them
+	// down to a core that encloses the hole by itself, assuming that copy
+	// 0 is the kernel.
+	bool getHoles( std::vector<std::vector<tile_index>>& holes, 
+		bool minimal = false );
 
 private:
-	void computeHalo();
-	bool search( const point_t& cell, point_set<coord_t>& visited,
-		std::unordered_set<tile_index>& owners ) const;
+	using word_t = uint64_t;
+	using bits_t = std::vector<word_t>;
+
+	// Cells with the same neighbour vectors, which can therefore be
+	// flooded together.
+	struct NbrClass
+	{
+		const point<int8_t> *vecs_;
+		size_t num_;
+		bits_t mask_;
+	};
+
+	size_t index( const point_t& p ) const
+	{
+		return size_t(p.y_ - min_.y_) * width_ + size_t(p.x_ - min_.x_);
+	}
+	point_t position( size_t idx ) const
+	{
+		return { coord_t( min_.x_ + coord_t(idx % width_) ),
+			coord_t( min_.y_ + coord_t(idx / width_) ) };
+	}
+	bool inside( const point_t& p ) const
+	{
+		return (p.x_ >= min_.x_) && (p.y_ >= min_.y_)
+			&& (size_t(p.x_ - min_.x_) < width_)
+			&& (size_t(p.y_ - min_.y_) < height_);
+	}
+	bool test( const bits_t& bits, size_t idx ) const
+	{
+		size_t y = idx / width_;
+		size_t x = idx % width_;
+		return (bits[y * words_ + (x >> 6)] >> (x & 63)) & 1;
+	}
+	void assign( bits_t& bits, size_t idx, bool val ) const
+	{
+		size_t y = idx / width_;
+		size_t x = idx % width_;
+		word_t bit = word_t(1) << (x & 63);
+		if( val ) {
+			bits[y * words_ + (x >> 6)] |= bit;
+		} else {
+			bits[y * words_ + (x >> 6)] &= ~bit;
+		}
+	}
+
+	void update( tile_index idx, const xform_t& T, bool add );
+	void updateHalo( size_t idx );
+	bool flood( bits_t& reach, const bits_t& within, size_t start,
+		const std::vector<NbrClass>& classes, 
+		const bits_t *stop = nullptr ) const;
+	void addClass( std::vector<NbrClass>& classes, const point_t& p,
+		const point<int8_t> *vecs, size_t num );
+	void paint( bits_t& bits, tile_index idx, bool val ) const;
+	bool encloses( size_t cell );
+	void getCore( size_t cell, std::vector<tile_index>& owners );
+	void shiftInto( bits_t& dst, const bits_t& src,
+		int dx, int dy, size_t ylo, size_t yhi ) const;
 
 	const Shape<grid>& shape_;
-	point_map<coord_t,tile_index> cells_;
 
-	point_set<coord_t> halo_;
-	point_t halo_min_;
+	point_t min_;
+	size_t width_;
+	size_t height_;
+	// Words per row.
+	size_t words_;
+
+	// The cells grouped by their edge neighbours and by all of their
+	// neighbours.
+	std::vector<NbrClass> edge_classes_;
+	std::vector<NbrClass> all_classes_;
+
+	// The cells that the grid knows about, and those among them that
+	// have a neighbour outside.
+	bits_t valid_;
+	bits_t border_;
+
+	// Which copies are present, and where.
+	std::vector<bool> present_;
+	std::vector<xform_t> xforms_;
+
+	// The kernel's cells, if it's present.
+	bits_t kernel_;
+
+	// Per cell: the number of copies covering it, the xor of their
+	// indices (which is the copy itself if there's only one), and the
+	// number of covered cells it neighbours.
+	std::vector<uint8_t> cover_;
+	std::vector<tile_index> owner_;
+	std::vector<uint16_t> near_;
+
+	// Empty cells that neighbour a covered cell.
+	bits_t halo_;
+	size_t halo_size_;
+
+	// The furthest any edge neighbour is from its cell vertically.
+	size_t reach_y_;
+
+	// Scratch space for flood fills.
+	bits_t reach_;
+	bits_t left_;
+	bits_t wall_;
+	bits_t stop_;
+	mutable bits_t part_;
+	mutable bits_t front_;
+	mutable bits_t next_;
 };
 
 template<typename grid>
-HoleFinder<grid>::HoleFinder( const Shape<grid>& shape )
+HoleFinder<grid>::HoleFinder(
+		const Shape<grid>& shape, const std::vector<point_t>& cells )
 	: shape_ { shape }
-	, cells_ {}
-{}
+	, min_ {}
+	, width_ { 0 }
+	, height_ { 0 }
+	, words_ { 0 }
+	, edge_classes_ {}
+	, all_classes_ {}
+	, valid_ {}
+	, border_ {}
+	, present_ {}
+	, xforms_ {}
+	, kernel_ {}
+	, cover_ {}
+	, owner_ {}
+	, near_ {}
+	, halo_ {}
+	, halo_size_ { 0 }
+	, reach_y_ { 0 }
+	, reach_ {}
+	, left_ {}
+	, wall_ {}
+	, stop_ {}
+	, part_ {}
+	, front_ {}
+	, next_ {}
+{
+	// The halo of any patch lies among the neighbours of the cells.
+	point_set<coord_t> all;
+	for( const auto& p : cells ) {
+		all.insert( p );
+		for( auto pn : neighbours<grid> { p } ) {
+			all.insert( pn );
+		}
+	}
+	if( all.empty() ) {
+		return;
+	}
+
+	point_t mx = *all.begin();
+	min_ = mx;
+	for( const auto& p : all ) {
+		min_.x_ = std::min( min_.x_, p.x_ );
+		min_.y_ = std::min( min_.y_, p.y_ );
+		mx.x_ = std::max( mx.x_, p.x_ );
+		mx.y_ = std::max( mx.y_, p.y_ );
+	}
+	width_ = size_t(mx.x_ - min_.x_) + 1;
+	height_ = size_t(mx.y_ - min_.y_) + 1;
+	words_ = (width_ + 63) / 64;
+
+	size_t num_words = words_ * height_;
+	size_t num_cells = width_ * height_;
+	cover_.assign( num_cells, 0 );
+	owner_.assign( num_cells, 0 );
+	near_.assign( num_cells, 0 );
+	halo_.assign( num_words, 0 );
+	valid_.assign( num_words, 0 );
+	border_.assign( num_words, 0 );
+	kernel_.assign( num_words, 0 );
+	reach_.assign( num_words, 0 );
+	left_.assign( num_words, 0 );
+	wall_.assign( num_words, 0 );
+	stop_.assign( num_words, 0 );
+	part_.assign( num_words, 0 );
+	front_.assign( num_words, 0 );
+	next_.assign( num_words, 0 );
+
+	for( const auto& p : all ) {
+		assign( valid_, index( p ), true );
+		addClass( edge_classes_, p, 
+			grid::getEdgeNeighbourVectors( p ), grid::numEdgeNeighbours( p ) );
+		addClass( all_classes_, p, 
+			grid::getNeighbourVectors( p ), grid::numNeighbours( p ) );
+
+		for( auto pn : neighbours<grid> { p } ) {
+			if( all.find( pn ) == all.end() ) {
+				assign( border_, index( p ), true );
+				break;
+			}
+		}
+	}
+}
+
+template<typename grid>
+void HoleFinder<grid>::addClass( std::vector<NbrClass>& classes, 
+	const point_t& p, const point<int8_t> *vecs, size_t num )
+{
+	NbrClass *nc = nullptr;
+	for( auto& c : classes ) {
+		if( (c.vecs_ == vecs) && (c.num_ == num) ) {
+			nc = &c;
+			break;
+		}
+	}
+	if( nc == nullptr ) {
+		classes.push_back( { vecs, num, bits_t( halo_.size(), 0 ) } );
+		nc = &classes.back();
+		for( size_t n = 0; n < num; ++n ) {
+			size_t dy = std::abs( int(vecs[n].y_) );
+			reach_y_ = std::max( reach_y_, dy );
+		}
+	}
+	assign( nc->mask_, index( p ), true );
+}
 
 template<typename grid>
 void HoleFinder<grid>::addCopy( tile_index idx, const xform_t& T )
 {
-	for( auto& p: shape_ ) {
-		cells_[ T * p ] = idx;
+	if( (size_t( idx ) < present_.size()) && present_[idx] ) {
+		return;
 	}
+	if( size_t( idx ) >= present_.size() ) {
+		present_.resize( idx + 1, false );
+	}
+	present_[idx] = true;
+	if( size_t( idx ) >= xforms_.size() ) {
+		xforms_.resize( idx + 1 );
+	}
+	xforms_[idx] = T;
+	update( idx, T, true );
 }
 
 template<typename grid>
-void HoleFinder<grid>::computeHalo()
+void HoleFinder<grid>::removeCopy( tile_index idx, const xform_t& T )
 {
-	halo_.clear();
-	bool start = true;
+	if( (size_t( idx ) >= present_.size()) || !present_[idx] ) {
+		return;
+	}
+	present_[idx] = false;
+	update( idx, T, false );
+}
 
-	for( auto i : cells_ ) {
-		point_t p = i.first;
+template<typename grid>
+void HoleFinder<grid>::update( tile_index idx, const xform_t& T, bool add )
+{
+	for( const auto& p : shape_ ) {
+		point_t tp = T * p;
+		if( !inside( tp ) ) {
+			std::cerr << "Copy out of range in HoleFinder" << std::endl;
+			exit( 0 );
+		}
 
-		for( auto pn : neighbours<grid> { p } ) {
-			// If pn isn't already a cell, add it with index -1 to
-			// indicate a halo cell.
-			if( cells_.find( pn ) == cells_.end() ) {
-				halo_.insert( pn );
-
-				// Track the minimum halo point, which is guaranteed
-				// to lie on the outer boundary.
-				if( start || (pn < halo_min_) ) {
-					halo_min_ = pn;
-					start = false;
-				}
+		size_t cidx = index( tp );
+		owner_[cidx] ^= idx;
+		if( idx == 0 ) {
+			assign( kernel_, cidx, add );
+		}
+		if( add ) {
+			++cover_[cidx];
+		} else {
+			--cover_[cidx];
+		}
+		updateHalo( cidx );
+
+		for( auto pn : neighbours<grid> { tp } ) {
+			size_t nidx = index( pn );
+			if( add ) {
+				++near_[nidx];
+			} else {
+				--near_[nidx];
 			}
+			updateHalo( nidx );
 		}
 	}
 }
 
 template<typename grid>
-bool HoleFinder<grid>::search( const point_t& cell, 
-	point_set<coord_t>& visited, std::unordered_set<tile_index>& owners ) const
+void HoleFinder<grid>::updateHalo( size_t idx )
 {
-	std::stack<point_t> working;
-	working.push( cell );
-	bool was_outer = false;
-
-	while( !working.empty() ) {
-		auto p = working.top();
-		working.pop();
-
-		if( visited.find( p ) == visited.end() ) {
-			// Haven't visited this point yet.
-			visited.insert( p );
-
-			if( p == halo_min_ ) {
-				// Part of this search turned up a cell known to be on
-				// the outer halo ring, which is definitely not a hole.
-				// Make a note of this, but you must continue exploring
-				// the whole component.
-				was_outer = true;
-			}
+	bool was = test( halo_, idx );
+	bool is = (cover_[idx] == 0) && (near_[idx] > 0);
+	if( was != is ) {
+		assign( halo_, idx, is );
+		if( is ) {
+			++halo_size_;
+		} else {
+			--halo_size_;
+		}
+	}
+}
+
+// OR src, translated by (dx,dy), into dst, looking only at rows ylo..yhi
+// of src.
+template<typename grid>
+void HoleFinder<grid>::shiftInto( bits_t& dst, const bits_t& src,
+	int dx, int dy, size_t ylo, size_t yhi ) const
+{
+	// Edge neighbours are never a whole word apart.
+	int shift = (dx < 0) ? -dx : dx;
+
+	for( size_t y = ylo; y <= yhi; ++y ) {
+		long ty = long(y) + dy;
+		if( (ty < 0) || (ty >= long(height_)) ) {
+			continue;
+		}
+		const word_t *s = &src[y * words_];
+		word_t *d = &dst[size_t(ty) * words_];
 
-			// Continue on to all edge neighbours that are halo cells.
-			for( auto pn : edge_neighbours<grid> { p } ) {
-				if( halo_.find( pn ) != halo_.end() ) {
-					// This is an adjacent halo cell, so continue the search.
-					working.push( pn );
+		for( size_t w = 0; w < words_; ++w ) {
+			word_t v;
+			if( dx == 0 ) {
+				v = s[w];
+			} else if( dx > 0 ) {
+				v = s[w] << shift;
+				if( w > 0 ) {
+					v |= s[w-1] >> (64 - shift);
+				}
+			} else {
+				v = s[w] >> shift;
+				if( w + 1 < words_ ) {
+					v |= s[w+1] << (64 - shift);
 				}
 			}
+			d[w] |= v;
+		}
+	}
+}
 
-			// Check for hole boundary cells
-			for( auto pn : neighbours<grid> { p } ) {
-				auto i = cells_.find( pn );
-				if( i != cells_.end() ) {
-					owners.insert( i->second );
+// Add to reach the cells of within connected to start through the
+// given kinds of neighbours, growing it a step at a time from a frontier
+// of newly reached cells.  Only the rows near the frontier need to be 
+// looked at.  Stop early and return true if the fill gets into stop.
+template<typename grid>
+bool HoleFinder<grid>::flood( bits_t& reach, const bits_t& within, 
+	size_t start, const std::vector<NbrClass>& classes, 
+	const bits_t *stop ) const
+{
+	if( stop && test( *stop, start ) ) {
+		return true;
+	}
+	assign( front_, start, true );
+	assign( reach, start, true );
+	size_t ylo = start / width_;
+	size_t yhi = ylo;
+
+	while( true ) {
+		size_t nlo = (ylo > reach_y_) ? (ylo - reach_y_) : 0;
+		size_t nhi = std::min( yhi + reach_y_, height_ - 1 );
+		std::fill( next_.begin() + nlo * words_, 
+			next_.begin() + (nhi + 1) * words_, 0 );
+
+		for( const auto& c : classes ) {
+			bool any = false;
+			for( size_t w = ylo * words_; w < (yhi + 1) * words_; ++w ) {
+				part_[w] = front_[w] & c.mask_[w];
+				any = any || part_[w];
+			}
+			if( !any ) {
+				continue;
+			}
+			for( size_t n = 0; n < c.num_; ++n ) {
+				shiftInto( next_, part_, 
+					c.vecs_[n].x_, c.vecs_[n].y_, ylo, yhi );
+			}
+		}
+
+		// Bits shifted past the end of a row never make it into within.
+		// The old frontier lies within the rows rewritten here.
+		size_t flo = height_;
+		size_t fhi = 0;
+		bool stopped = false;
+		for( size_t y = nlo; y <= nhi; ++y ) {
+			for( size_t w = y * words_; w < (y + 1) * words_; ++w ) {
+				word_t v = next_[w] & within[w] & ~reach[w];
+				front_[w] = v;
+				if( v ) {
+					reach[w] |= v;
+					flo = std::min( flo, y );
+					fhi = y;
+					stopped = stopped || (stop && (v & (*stop)[w]));
 				}
 			}
 		}
+		if( stopped ) {
+			std::fill( front_.begin() + nlo * words_, 
+				front_.begin() + (nhi + 1) * words_, 0 );
+			return true;
+		} else if( flo > fhi ) {
+			return false;
+		}
+		ylo = flo;
+		yhi = fhi;
+	}
+}
+
+template<typename grid>
+void HoleFinder<grid>::paint( bits_t& bits, tile_index idx, bool val ) const
+{
+	for( const auto& p : shape_ ) {
+		assign( bits, index( xforms_[idx] * p ), val );
+	}
+}
+
+// Whether the copies in wall_ cut cell off from the kernel and from 
+// everything beyond the cells that the finder knows about, even through
+// corners.  If so, no copy could sit in the region around cell: it would
+// have no chain of neighbours leading back down to the kernel.
+template<typename grid>
+bool HoleFinder<grid>::encloses( size_t cell )
+{
+	reach_ = wall_;
+	return !flood( reach_, valid_, cell, all_classes_, &stop_ );
+}
+
+// Shrink the copies around the hole containing cell to a subset that 
+// still encloses it, dropping them one at a time.  If they don't enclose
+// the hole as well as encloses() can tell, leave them all.
+template<typename grid>
+void HoleFinder<grid>::getCore( size_t cell, std::vector<tile_index>& owners )
+{
+	std::fill( wall_.begin(), wall_.end(), 0 );
+	for( auto tidx : owners ) {
+		paint( wall_, tidx, true );
+	}
+	if( !encloses( cell ) ) {
+		return;
 	}
 
-	return !was_outer;
+	size_t kept = 0;
+	for( size_t idx = 0; idx < owners.size(); ++idx ) {
+		tile_index tidx = owners[idx];
+		paint( wall_, tidx, false );
+		if( !encloses( cell ) ) {
+			paint( wall_, tidx, true );
+			owners[kept++] = tidx;
+		}
+	}
+	owners.resize( kept );
 }
 
 template<typename grid>
-bool HoleFinder<grid>::getHoles( std::vector<std::vector<tile_index>>& holes )
+bool HoleFinder<grid>::getHoles( 
+	std::vector<std::vector<tile_index>>& holes, bool minimal )
 {
-	computeHalo();
 	holes.clear();
+	if( halo_size_ == 0 ) {
+		return false;
+	}
 
-	// We know about halo cells, so now search them all, extracting connected
-	// components, and recording hole owners as needed.
+	// The first halo cell in row order is the minimum halo point, which
+	// is guaranteed to lie on the outer boundary.  Everything in the halo
+	// that isn't connected to it is part of a hole.
+	size_t w = 0;
+	while( halo_[w] == 0 ) {
+		++w;
+	}
+	size_t start = (w / words_) * width_
+		+ (w % words_) * 64 + __builtin_ctzll( halo_[w] );
+
+	std::fill( reach_.begin(), reach_.end(), 0 );
+	flood( reach_, halo_, start, edge_classes_ );
 
-	point_set<coord_t> visited;
 	bool found_one = false;
+	for( size_t idx = 0; idx < halo_.size(); ++idx ) {
+		left_[idx] = halo_[idx] & ~reach_[idx];
+		found_one = found_one || left_[idx];
+	}
+	if( !found_one ) {
+		return false;
+	}
+
+	if( minimal ) {
+		for( size_t idx = 0; idx < stop_.size(); ++idx ) {
+			stop_[idx] = border_[idx] | kernel_[idx];
+		}
+	}
 
-	for( auto& p: halo_ ) {
-		if( visited.find( p ) == visited.end() ) {
-			// Another connected component to visit
-			std::unordered_set<tile_index> owners;
-			if( search( p, visited, owners ) ) {
-				// It was a hole!
-				found_one = true;
-				holes.emplace_back( owners.begin(), owners.end() );
+	// Pull out one connected component of the remaining halo cells at a
+	// time, recording hole owners.
+	std::vector<bool> seen;
+	for( ; w < left_.size(); ++w ) {
+		while( left_[w] ) {
+			size_t first = (w / words_) * width_
+				+ (w % words_) * 64 + __builtin_ctzll( left_[w] );
+			std::fill( reach_.begin(), reach_.end(), 0 );
+			flood( reach_, left_, first, edge_classes_ );
+
+			std::vector<tile_index> owners;
+			for( size_t v = w; v < left_.size(); ++v ) {
+				word_t bits = reach_[v];
+				left_[v] &= ~bits;
+				while( bits ) {
+					size_t idx = (v / words_) * width_
+						+ (v % words_) * 64 + __builtin_ctzll( bits );
+					bits &= bits - 1;
+
+					for( auto pn : neighbours<grid> { position( idx ) } ) {
+						if( !inside( pn ) ) {
+							continue;
+						}
+						size_t nidx = index( pn );
+						if( cover_[nidx] == 0 ) {
+							continue;
+						}
+						tile_index tidx = owner_[nidx];
+						if( size_t( tidx ) >= seen.size() ) {
+							seen.resize( tidx + 1, false );
+						}
+						if( !seen[tidx] ) {
+							seen[tidx] = true;
+							owners.push_back( tidx );
+						}
+					}
+				}
+			}
+
+			for( auto tidx : owners ) {
+				seen[tidx] = false;
+			}
+			if( minimal ) {
+				getCore( first, owners );
 			}
+			holes.push_back( std::move( owners ) );
 		}
 	}
 
-	return found_one;
+	return true;
 }
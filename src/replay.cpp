@@ -0,0 +1,162 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+
+#include "grid.h"
+#include "tileio.h"
+
+// Solve a corona problem written out by sat or surrounds with -dumpcnf,
+// and turn the model back into a patch using the sidecar .map file.
+
+using namespace std;
+
+static string backend = "cryptominisat";
+static double time_budget = 0.0;
+static uint64_t conflict_budget = 0;
+
+static void readDIMACS( istream& is, SATBackend& solv )
+{
+	vector<sat_lit> cl;
+	sat_lit l;
+
+	while( is >> ws ) {
+		int ch = is.peek();
+		if( ch == EOF ) {
+			break;
+		} else if( ch == 'c' ) {
+			is.ignore( numeric_limits<streamsize>::max(), '\n' );
+		} else if( ch == 'p' ) {
+			string p;
+			string fmt;
+			size_t vars;
+			size_t clauses;
+			is >> p >> fmt >> vars >> clauses;
+			solv.newVars( vars );
+		} else if( is >> l ) {
+			if( l == 0 ) {
+				solv.addClause( cl );
+				cl.clear();
+			} else {
+				cl.push_back( l );
+			}
+		} else {
+			break;
+		}
+	}
+}
+
+template<typename grid>
+static bool decodeModel( istream *is, const SATBackend *solv, ostream *os )
+{
+	using coord_t = typename grid::coord_t;
+	using xform_t = typename grid::xform_t;
+
+	// The map starts with the shape, as a naked tile record.
+	TileInfo<grid> tile { *is };
+	Solution<coord_t> soln;
+
+	char buf[1000];
+	while( is->getline( buf, 1000 ) ) {
+		if( buf[0] != 't' ) {
+			continue;
+		}
+
+		// A tile's transform, followed by its variable at each level.
+		IntReader<int> i { buf };
+		IntReader<int> iend { buf + strlen( buf ) };
+		xform_t T { coord_t( *i++ ), coord_t( *i++ ), coord_t( *i++ ),
+			coord_t( *i++ ), coord_t( *i++ ), coord_t( *i++ ) };
+		for( size_t level = 0; i != iend; ++level ) {
+			int v = *i++;
+			if( (v > 0) && solv->value( litVar( v ) ) ) {
+				soln.emplace_back( level, T );
+				break;
+			}
+		}
+	}
+
+	// There's no record type for a bare patch; viz draws the patch of
+	// an inconclusive record.
+	tile.setInconclusive( &soln );
+	tile.write( *os );
+	return true;
+}
+GRID_WRAP( decodeModel );
+
+int main( int argc, char **argv )
+{
+	const char *inname = nullptr;
+	const char *outname = nullptr;
+
+	for( int idx = 1; idx < argc; ++idx ) {
+		if( !strcmp( argv[idx], "-o" ) ) {
+			outname = optionValue( argc, argv, idx );
+		} else if( !strcmp( argv[idx], "-solver" ) ) {
+			backend = optionValue( argc, argv, idx );
+		} else if( !strcmp( argv[idx], "-timeout" ) ) {
+			time_budget = atof( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-conflicts" ) ) {
+			conflict_budget = strtoull( 
+				optionValue( argc, argv, idx ), nullptr, 10 );
+		} else {
+			// Maybe an input filename?
+			if( filesystem::exists( argv[idx] ) ) {
+				inname = argv[idx];
+			} else {
+				cerr << "Argument \"" << argv[idx]
+					<< "\" is neither a file name nor a valid parameter"
+					<< endl;
+				exit( 0 );
+			}
+		}
+	}
+
+	if( inname == nullptr ) {
+		cerr << "Usage: replay [-solver <name>] [-timeout <seconds>] "
+			<< "[-conflicts <n>] [-o <out.txt>] <problem.cnf>" << endl;
+		exit( 0 );
+	}
+
+	auto solv = makeSATBackend( backend );
+	if( !solv ) {
+		cerr << "Unknown SAT solver \"" << backend << "\"" << endl;
+		exit( 0 );
+	}
+	solv->setTimeBudget( time_budget );
+	solv->setConflictBudget( conflict_budget );
+
+	ifstream cnf { inname };
+	readDIMACS( cnf, *solv );
+
+	auto start = chrono::steady_clock::now();
+	SATResult res = solv->solve();
+	double secs = chrono::duration<double>(
+		chrono::steady_clock::now() - start ).count();
+
+	cerr << ((res == SAT_SATISFIABLE) ? "SATISFIABLE"
+		: (res == SAT_UNSATISFIABLE) ? "UNSATISFIABLE" : "UNKNOWN")
+		<< " after " << secs << " seconds" << endl;
+
+	if( res != SAT_SATISFIABLE ) {
+		return 0;
+	}
+
+	ifstream map { filesystem::path( inname ).replace_extension( ".map" ) };
+	if( !map ) {
+		cerr << "No variable map for " << inname << endl;
+		return 0;
+	}
+
+	ofstream ofs;
+	ostream *out = &cout;
+	if( outname ) {
+		ofs.open( outname );
+		out = &ofs;
+	}
+
+	GridType gt = getGridType( map.get() );
+	GRID_DISPATCH( decodeModel, gt, &map, solv.get(), out );
+
+	return 0;
+}
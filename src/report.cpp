@@ -13,6 +13,7 @@ static size_t total = 0;
 static size_t num_unknown = 0;
 static size_t num_hole = 0;
 static size_t num_inconclusive = 0;
+static size_t num_timeout = 0;
 static size_t num_nontiler = 0;
 static size_t num_isohedral = 0;
 static size_t num_anisohedral = 0;
@@ -38,6 +39,9 @@ static bool getShapeStats( const TileInfo<grid>& tile )
 		case info_t::INCONCLUSIVE:
 			++num_inconclusive;
 			break;
+		case info_t::TIMEOUT:
+			++num_timeout;
+			break;
 		case info_t::NONTILER: {
 			++num_nontiler;
 			size_t hc = tile.getHeeschConnected();
@@ -70,6 +74,7 @@ static void printReport( ostream& os )
 	os << "  " << num_unknown << " unprocessed" << endl;
 	os << "  " << num_hole << " with holes" << endl;
 	os << "  " << num_inconclusive << " inconclusive" << endl;
+	os << "  " << num_timeout << " timed out" << endl;
 	os << "  " << num_nontiler << " non-tilers" << endl;
 	for( const auto& r : hcs ) {
 		os << "    " << r.second << " with Hc = " << r.first << endl;
@@ -18,7 +18,27 @@ static Orientations ori = ALL;
 static bool check_hh = false;
 static bool reduce = false;
 static bool check_isohedral = false;
+static bool isohedral_only = false;
 static bool update_only = false;
+static bool incremental = false;
+static bool cell_amo = false;
+static LevelEncoding level_encoding = DIRECT_LEVELS;
+static bool break_symmetry = false;
+static bool warm_start = false;
+static bool hole_prop = false;
+static size_t hole_tuples = 0;
+static string backend = "cryptominisat";
+static size_t portfolio_size = 1;
+static size_t portfolio_clauses = 1000000;
+static double portfolio_time = 30.0;
+static size_t cube_threads = 0;
+static size_t cube_depth = 2;
+static double shape_timeout = 0.0;
+static double call_timeout = 0.0;
+static uint64_t call_conflicts = 0;
+static const char *dump_dir = nullptr;
+// Counts input records, to name the files written by -dumpcnf.
+static size_t shape_num = 0;
 
 static const char *inname = nullptr;
 static const char *outname = nullptr;
@@ -30,11 +50,14 @@ static bool computeHeesch( TileInfo<grid>& tile )
 {
 	using coord_t = typename grid::coord_t;
 
+	++shape_num;
+
 	if( update_only ) {
-		// If we're updating, we only want to deal with unknown or 
-		// inconclusive records.
+		// If we're updating, we only want to deal with unknown,
+		// inconclusive or timed-out records.
 		if( !((tile.getRecordType() == TileInfo<grid>::UNKNOWN) 
-				|| (tile.getRecordType() == TileInfo<grid>::INCONCLUSIVE)) ) {
+				|| (tile.getRecordType() == TileInfo<grid>::INCONCLUSIVE)
+				|| (tile.getRecordType() == TileInfo<grid>::TIMEOUT)) ) {
 			tile.write( *out );
 			return true;
 		}
@@ -52,14 +75,42 @@ static bool computeHeesch( TileInfo<grid>& tile )
 	Solution<coord_t> sh;
 	bool has_holes;
 
-	HeeschSolver<grid> solver { tile.getShape(), ori, reduce };
+	HeeschSolver<grid> solver { tile.getShape(), ori, reduce, level_encoding };
 	solver.setCheckIsohedral( check_isohedral );
 	solver.setCheckHoleCoronas( check_hh );
+	solver.setIncremental( incremental );
+	solver.setCellAtMostOne( cell_amo );
+	solver.setSymmetryBreaking( break_symmetry );
+	solver.setWarmStart( warm_start );
+	solver.setHolePropagation( hole_prop );
+	solver.setHoleTuples( hole_tuples );
+	solver.setBackend( backend );
+	solver.setPortfolio( portfolio_size, portfolio_clauses, portfolio_time );
+	solver.setCubeAndConquer( cube_threads, cube_depth );
+	solver.setBudget( shape_timeout, call_timeout, call_conflicts );
+	if( dump_dir ) {
+		solver.setDumpCNF( string( dump_dir ) + "/" + to_string( shape_num ) );
+	}
 
 	// FIXME: Don't do this if the tile has already been found to be
 	// unsurroundable. Either check that here, or in increaseLevel().
 	solver.increaseLevel();
 
+	if( isohedral_only ) {
+		// Settle isohedral tilers and unsurroundable shapes only, and 
+		// leave everything else unclassified for a later run.
+		if( solver.checkIsohedral() ) {
+			tile.setPeriodic( 1 );
+		} else if( solver.timedOut() ) {
+			tile.setTimedOut( 0 );
+		} else if( !solver.isSurroundable() ) {
+			tile.setNonTiler( 0, show_solution ? &sc : nullptr, 
+				0, show_solution ? &sh : nullptr );
+		}
+		tile.write( *out );
+		return true;
+	}
+
 	Solution<coord_t> cur;
 
 	while( true ) {
@@ -91,7 +142,10 @@ static bool computeHeesch( TileInfo<grid>& tile )
 		}
 	}
 
-	if( solver.getLevel() > max_level ) {
+	if( solver.timedOut() ) {
+		// Ran out of budget; keep the last level that was settled.
+		tile.setTimedOut( hc, show_solution ? &sc : nullptr );
+	} else if( solver.getLevel() > max_level ) {
 		// Exceeded maximum level, label it inconclusive
 		if( show_solution ) {
 			tile.setInconclusive( &cur );
@@ -117,23 +171,68 @@ int main( int argc, char **argv )
 		if( !strcmp( argv[idx], "-show" ) ) {
 			show_solution = true;
 		} else if( !strcmp( argv[idx], "-o" ) ) {
-			++idx;
-			outname = argv[idx];
+			outname = optionValue( argc, argv, idx );
 		} else if( !strcmp( argv[idx], "-maxlevel" ) ) {
-		    ++idx;
-		    max_level = atoi(argv[idx]);
+			max_level = atoi( optionValue( argc, argv, idx ) );
 		} else if( !strcmp( argv[idx], "-translations" ) ) {
 			ori = TRANSLATIONS_ONLY;
 		} else if( !strcmp( argv[idx], "-rotations" ) ) {
 			ori = TRANSLATIONS_ROTATIONS;
 		} else if( !strcmp( argv[idx], "-isohedral" ) ) {
 			check_isohedral = true;
+		} else if( !strcmp( argv[idx], "-isohedral-only" ) ) {
+			isohedral_only = true;
 		} else if( !strcmp( argv[idx], "-noisohedral" ) ) {
 			check_isohedral = false;
 		} else if( !strcmp( argv[idx], "-update" ) ) {
 			update_only = true;
 		} else if( !strcmp( argv[idx], "-hh" ) ) {
 			check_hh = true;
+		} else if( !strcmp( argv[idx], "-incremental" ) ) {
+			incremental = true;
+		} else if( !strcmp( argv[idx], "-amo" ) ) {
+			cell_amo = true;
+		} else if( !strcmp( argv[idx], "-ladder" ) ) {
+			level_encoding = LADDER_LEVELS;
+		} else if( !strcmp( argv[idx], "-symmetry" ) ) {
+			break_symmetry = true;
+		} else if( !strcmp( argv[idx], "-warmstart" ) ) {
+			warm_start = true;
+		} else if( !strcmp( argv[idx], "-holeprop" ) ) {
+			hole_prop = true;
+		} else if( !strcmp( argv[idx], "-holetuples" ) ) {
+			hole_tuples = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-solver" ) ) {
+			backend = optionValue( argc, argv, idx );
+			if( !makeSATBackend( backend ) ) {
+				cerr << "Unknown SAT solver \"" << backend 
+					<< "\"; available:";
+				for( const auto& name : getSATBackendNames() ) {
+					cerr << " " << name;
+				}
+				cerr << endl;
+				exit( 0 );
+			}
+		} else if( !strcmp( argv[idx], "-portfolio" ) ) {
+			portfolio_size = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-portfolio-clauses" ) ) {
+			portfolio_clauses = atol( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-portfolio-time" ) ) {
+			portfolio_time = atof( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-cubes" ) ) {
+			cube_threads = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-cube-depth" ) ) {
+			cube_depth = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-timeout" ) ) {
+			shape_timeout = atof( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-calltimeout" ) ) {
+			call_timeout = atof( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-conflicts" ) ) {
+			call_conflicts = strtoull( 
+				optionValue( argc, argv, idx ), nullptr, 10 );
+		} else if( !strcmp( argv[idx], "-dumpcnf" ) ) {
+			dump_dir = optionValue( argc, argv, idx );
+			filesystem::create_directories( dump_dir );
 		} else if( !strcmp( argv[idx], "-reduce" ) ) {
 			reduce = true;
 		} else if( !strcmp( argv[idx], "-noreduce" ) ) {
@@ -151,6 +250,11 @@ int main( int argc, char **argv )
 		}
 	}
 
+	if( (portfolio_size > 1) && (cube_threads > 0) ) {
+		cerr << "-portfolio and -cubes can't be used together" << endl;
+		exit( 0 );
+	}
+
 	if( outname ) {
 		ofs.open( outname );
 		out = &ofs;
@@ -0,0 +1,970 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+#include <cryptominisat.h>
+#include <solverconf.h>
+
+// A thin layer between HeeschSolver and the SAT solver that does the
+// actual work, so that solvers can be swapped without touching the
+// encoding.  Literals follow the IPASIR convention: variable v (counting
+// from zero) appears as v+1 in positive literals and -(v+1) in negative
+// ones.  Cryptominisat is always available; other solvers are compiled
+// in when the corresponding HEESCH_* macro is defined (see the Makefile).
+
+using var_id = uint32_t;
+using sat_lit = int32_t;
+
+inline sat_lit pos( var_id id )
+{
+	return sat_lit( id ) + 1;
+}
+
+inline sat_lit neg( var_id id )
+{
+	return -(sat_lit( id ) + 1);
+}
+
+inline var_id litVar( sat_lit l )
+{
+	return var_id( std::abs( l ) - 1 );
+}
+
+enum SATResult
+{
+	SAT_UNKNOWN,
+	SAT_SATISFIABLE,
+	SAT_UNSATISFIABLE
+};
+
+// A theory that follows the solver's assignments to a set of variables
+// as it searches, and supplies clauses that the CNF leaves out, usually
+// because there would be far too many of them.  Only some backends can
+// consult one during search (currently CaDiCaL, through its external
+// propagator interface); the rest can't, and their clients must check
+// complete models themselves.
+class SATPropagator
+{
+public:
+	virtual ~SATPropagator() {}
+
+	virtual const std::vector<var_id>& observedVars() const = 0;
+
+	// The solver assigned l, opened a new decision level, or undid
+	// every assignment made above the given decision level.
+	virtual void assign( sat_lit l ) = 0;
+	virtual void newLevel() = 0;
+	virtual void backtrack( size_t level ) = 0;
+
+	// If the assignment so far (which may be partial) violates a clause
+	// of the theory, store it in cl and return true.
+	virtual bool getClause( std::vector<sat_lit>& cl ) = 0;
+};
+
+class SATBackend
+{
+public:
+	virtual ~SATBackend() {}
+
+	// Add n new variables, numbered after the existing ones.
+	virtual void newVars( size_t n ) = 0;
+	virtual size_t numVars() const = 0;
+	virtual void addClause( const std::vector<sat_lit>& cl ) = 0;
+
+	// Solve under the given assumptions.  Returns SAT_UNKNOWN if a budget
+	// ran out first.
+	virtual SATResult solve( const std::vector<sat_lit>& assumps ) = 0;
+	SATResult solve()
+	{
+		return solve( {} );
+	}
+
+	// The value of a variable in the model found by the last successful
+	// call to solve().
+	virtual bool value( var_id v ) const = 0;
+
+	// Limits on every subsequent call to solve().  Zero means no limit.
+	virtual void setConflictBudget( uint64_t conflicts ) = 0;
+	virtual void setTimeBudget( double seconds ) = 0;
+
+	// Suggest that the solver try literal l first when it branches on
+	// its variable.  Backends without phase control ignore this.
+	virtual void setPhase( sat_lit )
+	{}
+
+	// Consult prop during every subsequent call to solve(), replacing 
+	// any previous propagator, or none if prop is null.  Returns false
+	// if the backend doesn't support propagators.
+	virtual bool setPropagator( SATPropagator * )
+	{
+		return false;
+	}
+
+	// Make a call to solve() running in another thread return SAT_UNKNOWN
+	// as soon as possible.  Every call to solve() starts afresh, so an
+	// interruption that arrives before it has started is lost.
+	virtual void interrupt() = 0;
+};
+
+class CMSatBackend
+	: public SATBackend
+{
+public:
+	// A non-zero seed varies the search, so that several instances can
+	// usefully race on the same problem.
+	CMSatBackend( unsigned seed = 0 )
+		: conf_ { makeConf( seed ) }
+		, stop_ { false }
+		, solver_ { &conf_, &stop_ }
+		, lits_ {}
+		, conflicts_ { 0 }
+		, seconds_ { 0.0 }
+		, watch_mutex_ {}
+		, watch_cv_ {}
+	{}
+
+	void newVars( size_t n ) override
+	{
+		solver_.new_vars( n );
+	}
+	size_t numVars() const override
+	{
+		return solver_.nVars();
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		solver_.add_clause( convert( cl ) );
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		// Cryptominisat measures its limits from the moment they're
+		// set, so renew them for each call.  They persist, so lift them
+		// explicitly when the budget is removed.  Its own time limit
+		// counts CPU time, so the time budget is enforced instead by a 
+		// watchdog thread that raises stop_ at the deadline.
+		solver_.set_max_confl( (conflicts_ > 0) 
+			? conflicts_ : std::numeric_limits<uint64_t>::max() );
+		stop_ = false;
+
+		std::thread watchdog;
+		bool finished = false;
+		if( seconds_ > 0.0 ) {
+			auto deadline = std::chrono::steady_clock::now()
+				+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>( seconds_ ) );
+			watchdog = std::thread( [this, deadline, &finished]() {
+				std::unique_lock<std::mutex> lock { watch_mutex_ };
+				if( !watch_cv_.wait_until( lock, deadline, 
+						[&finished] { return finished; } ) ) {
+					stop_ = true;
+				}
+			} );
+		}
+
+		CMSat::lbool res = solver_.solve( &convert( assumps ) );
+
+		if( watchdog.joinable() ) {
+			{
+				std::lock_guard<std::mutex> lock { watch_mutex_ };
+				finished = true;
+			}
+			watch_cv_.notify_one();
+			watchdog.join();
+		}
+		if( res == CMSat::l_True ) {
+			return SAT_SATISFIABLE;
+		} else if( res == CMSat::l_False ) {
+			return SAT_UNSATISFIABLE;
+		} else {
+			return SAT_UNKNOWN;
+		}
+	}
+	bool value( var_id v ) const override
+	{
+		return solver_.get_model()[v] == CMSat::l_True;
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		conflicts_ = conflicts;
+	}
+	void setTimeBudget( double seconds ) override
+	{
+		seconds_ = seconds;
+	}
+	void interrupt() override
+	{
+		stop_ = true;
+	}
+
+private:
+	static CMSat::SolverConf makeConf( unsigned seed )
+	{
+		CMSat::SolverConf conf;
+		conf.origSeed = seed;
+		return conf;
+	}
+
+	const std::vector<CMSat::Lit>& convert( const std::vector<sat_lit>& cl )
+	{
+		lits_.clear();
+		for( auto l : cl ) {
+			lits_.emplace_back( litVar( l ), l < 0 );
+		}
+		return lits_;
+	}
+
+	CMSat::SolverConf conf_;
+	std::atomic<bool> stop_;
+	CMSat::SATSolver solver_;
+	std::vector<CMSat::Lit> lits_;
+	uint64_t conflicts_;
+	double seconds_;
+	// Wakes the watchdog when a timed solve finishes early.
+	std::mutex watch_mutex_;
+	std::condition_variable watch_cv_;
+};
+
+#ifdef HEESCH_CADICAL
+#include <cadical.hpp>
+
+class CadicalBackend
+	: public SATBackend
+{
+public:
+	CadicalBackend( unsigned seed = 0 )
+		: solver_ {}
+		, nvars_ { 0 }
+		, conflicts_ { 0 }
+		, seconds_ { 0.0 }
+		, timer_ {}
+		, relay_ {}
+	{
+		if( seed > 0 ) {
+			solver_.set( "seed", int( seed ) );
+		}
+	}
+
+	void newVars( size_t n ) override
+	{
+		nvars_ += n;
+		solver_.reserve( nvars_ );
+	}
+	size_t numVars() const override
+	{
+		return nvars_;
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		for( auto l : cl ) {
+			solver_.add( l );
+		}
+		solver_.add( 0 );
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		for( auto l : assumps ) {
+			solver_.assume( l );
+		}
+		// Both limits apply only to the next call.
+		if( conflicts_ > 0 ) {
+			solver_.limit( "conflicts", int( std::min<uint64_t>( 
+				conflicts_, std::numeric_limits<int>::max() ) ) );
+		}
+		timer_.start( seconds_ );
+		solver_.connect_terminator( &timer_ );
+
+		int res = solver_.solve();
+		solver_.disconnect_terminator();
+
+		if( res == 10 ) {
+			return SAT_SATISFIABLE;
+		} else if( res == 20 ) {
+			return SAT_UNSATISFIABLE;
+		} else {
+			return SAT_UNKNOWN;
+		}
+	}
+	bool value( var_id v ) const override
+	{
+		return const_cast<CaDiCaL::Solver&>( solver_ ).val( pos( v ) ) > 0;
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		conflicts_ = conflicts;
+	}
+	void setTimeBudget( double seconds ) override
+	{
+		seconds_ = seconds;
+	}
+	void setPhase( sat_lit l ) override
+	{
+		solver_.phase( l );
+	}
+	bool setPropagator( SATPropagator *prop ) override
+	{
+		if( relay_.prop_ ) {
+			solver_.disconnect_external_propagator();
+		}
+		relay_.prop_ = prop;
+		relay_.clause_.clear();
+		if( prop ) {
+			solver_.connect_external_propagator( &relay_ );
+			for( auto v : prop->observedVars() ) {
+				solver_.add_observed_var( pos( v ) );
+			}
+		}
+		return true;
+	}
+	void interrupt() override
+	{
+		timer_.stop_ = true;
+	}
+
+private:
+	// Stops the solver when the time budget (if any) runs out, or when
+	// another thread calls interrupt().
+	struct Timer
+		: public CaDiCaL::Terminator
+	{
+		Timer()
+			: stop_ { false }
+			, timed_ { false }
+			, deadline_ {}
+		{}
+
+		void start( double seconds )
+		{
+			stop_ = false;
+			timed_ = seconds > 0.0;
+			if( timed_ ) {
+				deadline_ = std::chrono::steady_clock::now()
+					+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+						std::chrono::duration<double>( seconds ) );
+			}
+		}
+		bool terminate() override
+		{
+			return stop_ 
+				|| (timed_ && (std::chrono::steady_clock::now() > deadline_));
+		}
+
+		std::atomic<bool> stop_;
+		bool timed_;
+		std::chrono::steady_clock::time_point deadline_;
+	};
+
+	// Passes CaDiCaL's external propagator callbacks on to a 
+	// SATPropagator.  A clause found in a partial assignment or in a
+	// complete model is handed back one literal at a time.
+	struct Relay
+		: public CaDiCaL::ExternalPropagator
+	{
+		Relay()
+			: prop_ { nullptr }
+			, clause_ {}
+			, next_ { 0 }
+		{}
+
+		void notify_assignment( const std::vector<int>& lits ) override
+		{
+			for( auto l : lits ) {
+				prop_->assign( l );
+			}
+		}
+		void notify_new_decision_level() override
+		{
+			prop_->newLevel();
+		}
+		void notify_backtrack( size_t level ) override
+		{
+			prop_->backtrack( level );
+		}
+		bool cb_check_found_model( const std::vector<int>& ) override
+		{
+			return !pending();
+		}
+		bool cb_has_external_clause( bool& is_forgettable ) override
+		{
+			is_forgettable = false;
+			return pending();
+		}
+		int cb_add_external_clause_lit() override
+		{
+			if( next_ < clause_.size() ) {
+				return clause_[next_++];
+			}
+			clause_.clear();
+			return 0;
+		}
+
+		bool pending()
+		{
+			if( clause_.empty() ) {
+				next_ = 0;
+				return prop_->getClause( clause_ );
+			}
+			return true;
+		}
+
+		SATPropagator *prop_;
+		std::vector<sat_lit> clause_;
+		size_t next_;
+	};
+
+	CaDiCaL::Solver solver_;
+	size_t nvars_;
+	uint64_t conflicts_;
+	double seconds_;
+	Timer timer_;
+	Relay relay_;
+};
+#endif
+
+#ifdef HEESCH_KISSAT
+extern "C" {
+#include <kissat.h>
+}
+
+// Kissat isn't incremental, so record the clauses and hand them to a
+// new Kissat instance for every call to solve(), with assumptions
+// added as unit clauses.  Kissat has no time limit, so only the conflict
+// budget is honoured.
+class KissatBackend
+	: public SATBackend
+{
+public:
+	KissatBackend( unsigned seed = 0 )
+		: clauses_ {}
+		, model_ {}
+		, nvars_ { 0 }
+		, conflicts_ { 0 }
+		, seed_ { seed }
+		, mutex_ {}
+		, current_ { nullptr }
+	{}
+
+	void newVars( size_t n ) override
+	{
+		nvars_ += n;
+	}
+	size_t numVars() const override
+	{
+		return nvars_;
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		clauses_.insert( clauses_.end(), cl.begin(), cl.end() );
+		clauses_.push_back( 0 );
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		kissat *solver = kissat_init();
+		kissat_set_option( solver, "quiet", 1 );
+		if( seed_ > 0 ) {
+			kissat_set_option( solver, "seed", int( seed_ ) );
+		}
+		if( conflicts_ > 0 ) {
+			kissat_set_conflict_limit( solver, unsigned( conflicts_ ) );
+		}
+		for( auto l : clauses_ ) {
+			kissat_add( solver, l );
+		}
+		for( auto l : assumps ) {
+			kissat_add( solver, l );
+			kissat_add( solver, 0 );
+		}
+
+		// interrupt() may be called from another thread at any time, so
+		// the instance is only published once it's ready to solve, and
+		// withdrawn (under the same lock) before it's released.
+		{
+			std::lock_guard<std::mutex> lock { mutex_ };
+			current_ = solver;
+		}
+		int res = kissat_solve( solver );
+		{
+			std::lock_guard<std::mutex> lock { mutex_ };
+			current_ = nullptr;
+		}
+		if( res == 10 ) {
+			model_.resize( nvars_ );
+			for( var_id v = 0; v < nvars_; ++v ) {
+				model_[v] = kissat_value( solver, pos( v ) ) > 0;
+			}
+		}
+		kissat_release( solver );
+
+		if( res == 10 ) {
+			return SAT_SATISFIABLE;
+		} else if( res == 20 ) {
+			return SAT_UNSATISFIABLE;
+		} else {
+			return SAT_UNKNOWN;
+		}
+	}
+	bool value( var_id v ) const override
+	{
+		return model_[v];
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		conflicts_ = conflicts;
+	}
+	void setTimeBudget( double ) override
+	{}
+	void interrupt() override
+	{
+		std::lock_guard<std::mutex> lock { mutex_ };
+		if( current_ != nullptr ) {
+			kissat_terminate( current_ );
+		}
+	}
+
+private:
+	std::vector<sat_lit> clauses_;
+	std::vector<bool> model_;
+	size_t nvars_;
+	uint64_t conflicts_;
+	unsigned seed_;
+	std::mutex mutex_;
+	kissat *current_;
+};
+#endif
+
+#ifdef HEESCH_MINISAT
+// Included last, because MiniSat defines l_True and friends as macros.
+#include <minisat/core/Solver.h>
+
+// MiniSat has no time limit, so only the conflict budget is honoured.
+class MiniSatBackend
+	: public SATBackend
+{
+public:
+	MiniSatBackend( unsigned seed = 0 )
+		: solver_ {}
+		, lits_ {}
+		, conflicts_ { 0 }
+	{
+		if( seed > 0 ) {
+			solver_.random_seed = double( seed );
+			solver_.rnd_init_act = true;
+		}
+	}
+
+	void newVars( size_t n ) override
+	{
+		for( size_t idx = 0; idx < n; ++idx ) {
+			solver_.newVar();
+		}
+	}
+	size_t numVars() const override
+	{
+		return solver_.nVars();
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		solver_.addClause( convert( cl ) );
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		if( conflicts_ > 0 ) {
+			solver_.setConfBudget( int64_t( conflicts_ ) );
+		} else {
+			solver_.budgetOff();
+		}
+		solver_.clearInterrupt();
+
+		Minisat::lbool res = solver_.solveLimited( convert( assumps ) );
+		if( res == Minisat::lbool( (uint8_t)0 ) ) {
+			return SAT_SATISFIABLE;
+		} else if( res == Minisat::lbool( (uint8_t)1 ) ) {
+			return SAT_UNSATISFIABLE;
+		} else {
+			return SAT_UNKNOWN;
+		}
+	}
+	bool value( var_id v ) const override
+	{
+		return solver_.model[v] == Minisat::lbool( (uint8_t)0 );
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		conflicts_ = conflicts;
+	}
+	void setTimeBudget( double ) override
+	{}
+	void setPhase( sat_lit l ) override
+	{
+		// MiniSat's polarity is the sign of the literal, so l_True 
+		// (0) selects the negative literal.
+		solver_.setPolarity( 
+			litVar( l ), Minisat::lbool( (uint8_t)((l < 0) ? 0 : 1) ) );
+	}
+	void interrupt() override
+	{
+		solver_.interrupt();
+	}
+
+private:
+	const Minisat::vec<Minisat::Lit>& convert( const std::vector<sat_lit>& cl )
+	{
+		lits_.clear();
+		for( auto l : cl ) {
+			lits_.push( Minisat::mkLit( litVar( l ), l < 0 ) );
+		}
+		return lits_;
+	}
+
+	Minisat::Solver solver_;
+	Minisat::vec<Minisat::Lit> lits_;
+	uint64_t conflicts_;
+};
+#endif
+
+// The names of the backends compiled into this build, default first.
+inline std::vector<std::string> getSATBackendNames()
+{
+	return {
+		"cryptominisat",
+#ifdef HEESCH_CADICAL
+		"cadical",
+#endif
+#ifdef HEESCH_KISSAT
+		"kissat",
+#endif
+#ifdef HEESCH_MINISAT
+		"minisat",
+#endif
+	};
+}
+
+// Create a backend by name, or return nullptr if it isn't available.
+// Instances with different non-zero seeds search differently.
+inline std::unique_ptr<SATBackend> makeSATBackend( 
+	const std::string& name, unsigned seed = 0 )
+{
+	if( name == "cryptominisat" ) {
+		return std::make_unique<CMSatBackend>( seed );
+	}
+#ifdef HEESCH_CADICAL
+	if( name == "cadical" ) {
+		return std::make_unique<CadicalBackend>( seed );
+	}
+#endif
+#ifdef HEESCH_KISSAT
+	if( name == "kissat" ) {
+		return std::make_unique<KissatBackend>( seed );
+	}
+#endif
+#ifdef HEESCH_MINISAT
+	if( name == "minisat" ) {
+		return std::make_unique<MiniSatBackend>( seed );
+	}
+#endif
+	return nullptr;
+}
+
+// Pass everything through to another backend, keeping a copy of the
+// clauses so that the problem can be written out in DIMACS format.
+class RecordingBackend
+	: public SATBackend
+{
+public:
+	explicit RecordingBackend( std::unique_ptr<SATBackend> inner )
+		: inner_ { std::move( inner ) }
+		, clauses_ {}
+		, num_clauses_ { 0 }
+	{}
+
+	void newVars( size_t n ) override
+	{
+		inner_->newVars( n );
+	}
+	size_t numVars() const override
+	{
+		return inner_->numVars();
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		clauses_.insert( clauses_.end(), cl.begin(), cl.end() );
+		clauses_.push_back( 0 );
+		++num_clauses_;
+		inner_->addClause( cl );
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		return inner_->solve( assumps );
+	}
+	bool value( var_id v ) const override
+	{
+		return inner_->value( v );
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		inner_->setConflictBudget( conflicts );
+	}
+	void setTimeBudget( double seconds ) override
+	{
+		inner_->setTimeBudget( seconds );
+	}
+	void setPhase( sat_lit l ) override
+	{
+		inner_->setPhase( l );
+	}
+	bool setPropagator( SATPropagator *prop ) override
+	{
+		return inner_->setPropagator( prop );
+	}
+	void interrupt() override
+	{
+		inner_->interrupt();
+	}
+
+	// Write the clauses so far, with the assumptions as unit clauses.
+	void writeDIMACS( 
+		std::ostream& os, const std::vector<sat_lit>& assumps ) const
+	{
+		os << "p cnf " << numVars() << ' ' 
+			<< (num_clauses_ + assumps.size()) << '\n';
+		for( auto l : clauses_ ) {
+			os << l << ((l == 0) ? '\n' : ' ');
+		}
+		for( auto l : assumps ) {
+			os << l << " 0\n";
+		}
+	}
+
+private:
+	std::unique_ptr<SATBackend> inner_;
+	std::vector<sat_lit> clauses_;
+	size_t num_clauses_;
+};
+
+// Race several differently seeded instances of a backend on the same
+// clauses, one thread each, taking the first answer and interrupting the
+// rest.  Most problems are too easy to justify the extra threads and
+// memory, so a single instance works alone until the problem has more
+// than clause_limit clauses, or a call to solve() takes longer than
+// time_limit seconds.  Only then are the other instances created and
+// given the clauses seen so far.  A limit of zero disables that trigger;
+// with both disabled the race starts immediately.
+class PortfolioBackend
+	: public SATBackend
+{
+public:
+	PortfolioBackend( const std::string& name, size_t size, 
+			size_t clause_limit, double time_limit )
+		: name_ { name }
+		, size_ { size }
+		, clause_limit_ { clause_limit }
+		, time_limit_ { time_limit }
+		, solvers_ {}
+		, clauses_ {}
+		, num_clauses_ { 0 }
+		, nvars_ { 0 }
+		, winner_ { 0 }
+		, conflicts_ { 0 }
+		, seconds_ { 0.0 }
+	{
+		solvers_.push_back( makeSATBackend( name ) );
+	}
+
+	void newVars( size_t n ) override
+	{
+		nvars_ += n;
+		for( auto& s : solvers_ ) {
+			s->newVars( n );
+		}
+	}
+	size_t numVars() const override
+	{
+		return nvars_;
+	}
+	void addClause( const std::vector<sat_lit>& cl ) override
+	{
+		// Keep a copy for instances that haven't been created yet.
+		if( solvers_.size() < size_ ) {
+			clauses_.insert( clauses_.end(), cl.begin(), cl.end() );
+			clauses_.push_back( 0 );
+		}
+		++num_clauses_;
+		for( auto& s : solvers_ ) {
+			s->addClause( cl );
+		}
+	}
+	SATResult solve( const std::vector<sat_lit>& assumps ) override
+	{
+		if( solvers_.size() == size_ ) {
+			return race( assumps, seconds_ );
+		}
+
+		bool big = (clause_limit_ > 0) && (num_clauses_ > clause_limit_);
+		bool eager = (clause_limit_ == 0) && (time_limit_ == 0.0);
+		if( big || eager ) {
+			grow();
+			return race( assumps, seconds_ );
+		}
+		if( time_limit_ == 0.0 ) {
+			winner_ = 0;
+			return solvers_[0]->solve( assumps );
+		}
+
+		// Give the lone instance time_limit seconds (or less, if that's
+		// all the budget allows), and race if it doesn't finish.
+		SATBackend& first = *solvers_[0];
+		bool capped = (seconds_ > 0.0) && (seconds_ <= time_limit_);
+		first.setTimeBudget( capped ? seconds_ : time_limit_ );
+		auto start = std::chrono::steady_clock::now();
+		SATResult res = first.solve( assumps );
+		double elapsed = std::chrono::duration<double>( 
+			std::chrono::steady_clock::now() - start ).count();
+		first.setTimeBudget( seconds_ );
+
+		winner_ = 0;
+		if( (res != SAT_UNKNOWN) || capped || (elapsed < time_limit_) ) {
+			// Either an answer, or the caller's own budget ran out.
+			return res;
+		}
+
+		grow();
+		return race( assumps, 
+			(seconds_ > 0.0) ? std::max( seconds_ - elapsed, 1e-3 ) : 0.0 );
+	}
+	bool value( var_id v ) const override
+	{
+		return solvers_[winner_]->value( v );
+	}
+	void setConflictBudget( uint64_t conflicts ) override
+	{
+		conflicts_ = conflicts;
+		for( auto& s : solvers_ ) {
+			s->setConflictBudget( conflicts );
+		}
+	}
+	void setTimeBudget( double seconds ) override
+	{
+		seconds_ = seconds;
+		for( auto& s : solvers_ ) {
+			s->setTimeBudget( seconds );
+		}
+	}
+	void setPhase( sat_lit l ) override
+	{
+		// Only the first instance; the others are meant to search
+		// differently.
+		solvers_[0]->setPhase( l );
+	}
+	void interrupt() override
+	{
+		for( auto& s : solvers_ ) {
+			s->interrupt();
+		}
+	}
+
+private:
+	// Create the rest of the instances and bring them up to date.
+	void grow()
+	{
+		for( unsigned seed = solvers_.size(); seed < size_; ++seed ) {
+			auto s = makeSATBackend( name_, seed );
+			s->newVars( nvars_ );
+			s->setConflictBudget( conflicts_ );
+			s->setTimeBudget( seconds_ );
+
+			std::vector<sat_lit> cl;
+			for( auto l : clauses_ ) {
+				if( l == 0 ) {
+					s->addClause( cl );
+					cl.clear();
+				} else {
+					cl.push_back( l );
+				}
+			}
+			solvers_.push_back( std::move( s ) );
+		}
+
+		clauses_.clear();
+		clauses_.shrink_to_fit();
+	}
+
+	SATResult race( const std::vector<sat_lit>& assumps, double seconds )
+	{
+		if( seconds_ > 0.0 ) {
+			for( auto& s : solvers_ ) {
+				s->setTimeBudget( seconds );
+			}
+		}
+
+		size_t num = solvers_.size();
+		std::vector<SATResult> results( num, SAT_UNKNOWN );
+		std::atomic<int> winner { -1 };
+		std::atomic<size_t> running { num };
+
+		std::vector<std::thread> threads;
+		for( size_t idx = 0; idx < num; ++idx ) {
+			threads.emplace_back( [&, idx] {
+				results[idx] = solvers_[idx]->solve( assumps );
+				if( results[idx] != SAT_UNKNOWN ) {
+					int none = -1;
+					winner.compare_exchange_strong( none, int( idx ) );
+				}
+				--running;
+			} );
+		}
+
+		// An interruption is lost if it arrives before the instance
+		// starts solving, so keep repeating it until all have stopped.
+		while( running > 0 ) {
+			int w = winner;
+			if( w >= 0 ) {
+				for( size_t idx = 0; idx < num; ++idx ) {
+					if( int( idx ) != w ) {
+						solvers_[idx]->interrupt();
+					}
+				}
+			}
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		}
+		for( auto& t : threads ) {
+			t.join();
+		}
+
+		if( seconds_ > 0.0 ) {
+			for( auto& s : solvers_ ) {
+				s->setTimeBudget( seconds_ );
+			}
+		}
+
+		if( winner < 0 ) {
+			return SAT_UNKNOWN;
+		}
+		winner_ = size_t( winner );
+		return results[winner_];
+	}
+
+	std::string name_;
+	size_t size_;
+	size_t clause_limit_;
+	double time_limit_;
+
+	std::vector<std::unique_ptr<SATBackend>> solvers_;
+	// Every clause, zero-terminated, until all instances exist.
+	std::vector<sat_lit> clauses_;
+	size_t num_clauses_;
+	size_t nvars_;
+	size_t winner_;
+	uint64_t conflicts_;
+	double seconds_;
+};
@@ -2,8 +2,10 @@
 #include <cstdint>
 #include <sstream>
 #include <map>
+#include <filesystem>
 
 #include "heesch.h"
+#include "dlx.h"
 #include "grid.h"
 #include "tileio.h"
 #include "cloud.h"
@@ -15,6 +17,28 @@ using namespace std;
 static bool no_reflections = false;
 static bool extremes = false;
 static size_t heesch_level = 1;
+static string backend = "cryptominisat";
+// Enumerate with dancing links (dlx.h) instead of the SAT solver.
+static bool use_dlx = false;
+static bool hole_prop = false;
+// Flush standard output after every surround written.
+static bool flush_output = false;
+// Enumerate on this many threads, splitting the work by cube_depth
+// cells of the halo (see HeeschSolver::setCubeAndConquer()).
+static size_t cube_threads = 0;
+static size_t cube_depth = 2;
+static const char *dump_dir = nullptr;
+// Counts input records, to name the files written by -dumpcnf.
+static size_t shape_num = 0;
+
+template<typename grid>
+static void setDumpPrefix( HeeschSolver<grid>& solver )
+{
+	++shape_num;
+	if( dump_dir ) {
+		solver.setDumpCNF( string( dump_dir ) + "/" + to_string( shape_num ) );
+	}
+}
 
 template<typename grid>
 static size_t countEquivalentOrientations( const TileInfo<grid>& tile )
@@ -60,33 +84,38 @@ GRID_WRAP( describeNeighbours );
 template<typename grid>
 static bool countSurrounds( const TileInfo<grid>& tile )
 {
-	using coord_t = typename grid::coord_t;
-
 	TileInfo<grid> info { tile };
 
 	map<size_t,size_t> counts;
 	size_t num = 0;
 
-	HeeschSolver<grid> solver { 
-		info.getShape(), no_reflections ? TRANSLATIONS_ROTATIONS : ALL };
-		
-	for( size_t idx = 0; idx < heesch_level; ++idx ) {
-		solver.increaseLevel();
-	}
-
-	solver.allCoronas( [&counts, &num]( const Solution<coord_t>& soln ) {
-		counts[soln.size()-1]++; 
+	auto cb = [&counts, &num]( size_t size ) {
+		counts[size-1]++; 
 		++num; 
-		/*
-		if( soln.size() == 15 ) {
-			info.setNonTiler( 1, &soln, 1, nullptr );
-			info.write( cout );
-		}
-		*/
 		if( num % 100000 == 0 ) {
 			cerr << ".";
 		}
-		return true; } );
+		return true; };
+
+	if( use_dlx ) {
+		Cloud<grid> cloud { info.getShape(), 
+			no_reflections ? TRANSLATIONS_ROTATIONS : ALL, true };
+		SurroundDLX<grid> dlx { info.getShape(), cloud };
+		dlx.countCoronas( cb );
+	} else {
+		HeeschSolver<grid> solver { 
+			info.getShape(), no_reflections ? TRANSLATIONS_ROTATIONS : ALL };
+		solver.setBackend( backend );
+		solver.setHolePropagation( hole_prop );
+		solver.setCubeAndConquer( cube_threads, cube_depth );
+		setDumpPrefix( solver );
+			
+		for( size_t idx = 0; idx < heesch_level; ++idx ) {
+			solver.increaseLevel();
+		}
+
+		solver.countCoronas( cb );
+	}
 
 	cerr << endl;
 
@@ -107,37 +136,59 @@ static bool computeSurrounds( const TileInfo<grid>& tile )
 
 	TileInfo<grid> info { tile };
 
-	HeeschSolver<grid> solver { 
-		info.getShape(), no_reflections ? TRANSLATIONS_ROTATIONS : ALL };
-		
-	for( size_t idx = 0; idx < heesch_level; ++idx ) {
-		solver.increaseLevel();
-	}
-
-	std::vector<Solution<coord_t>> cur;
-	solver.allCoronas( cur );
-
-	if( extremes ) {
-		Solution<coord_t> smallest = cur[0];
-		Solution<coord_t> largest = cur[0];
+	// Write each surround as soon as it's found, or with -extremes,
+	// just remember the smallest and largest seen so far.
+	Solution<coord_t> smallest;
+	Solution<coord_t> largest;
+	size_t num = 0;
 
-		for( const auto& soln : cur ) {
-			if( soln.size() < smallest.size() ) {
+	auto cb = [&info, &smallest, &largest, &num]( 
+			const Solution<coord_t>& soln ) {
+		++num;
+		if( extremes ) {
+			if( (num == 1) || (soln.size() < smallest.size()) ) {
 				smallest = soln;
-			} else if( soln.size() > largest.size() ) {
+			}
+			if( (num == 1) || (soln.size() > largest.size()) ) {
 				largest = soln;
 			}
+		} else {
+			info.setNonTiler( 1, &soln, 1, nullptr );
+			info.write( cout );
+			if( flush_output ) {
+				cout.flush();
+			}
 		}
+		return true; };
+
+	if( use_dlx ) {
+		Cloud<grid> cloud { info.getShape(), 
+			no_reflections ? TRANSLATIONS_ROTATIONS : ALL, true };
+		SurroundDLX<grid> dlx { info.getShape(), cloud };
+		dlx.allCoronas( cb );
+	} else {
+		HeeschSolver<grid> solver { 
+			info.getShape(), no_reflections ? TRANSLATIONS_ROTATIONS : ALL };
+		solver.setBackend( backend );
+		solver.setHolePropagation( hole_prop );
+		solver.setCubeAndConquer( cube_threads, cube_depth );
+		setDumpPrefix( solver );
+			
+		for( size_t idx = 0; idx < heesch_level; ++idx ) {
+			solver.increaseLevel();
+		}
+
+		solver.allCoronas( cb );
+	}
 
+	if( extremes && (num > 0) ) {
 		info.setNonTiler( 1, &smallest, 1, nullptr );
 		info.write( cout );
 		info.setNonTiler( 1, &largest, 1, nullptr );
 		info.write( cout );
-	} else {
-		for( const auto& soln : cur ) {
-			info.setNonTiler( 1, &soln, 1, nullptr );
-			info.write( cout );
-		}
+	}
+	if( flush_output ) {
+		cout.flush();
 	}
 	return true;
 }
@@ -150,8 +201,7 @@ int main( int argc, char **argv )
 
 	for( int idx = 1; idx < argc; ++idx ) {
 		if( !strcmp( argv[idx], "-level" ) ) {
-		    heesch_level = atoi(argv[idx+1]);
-		    ++idx;
+		    heesch_level = atoi( optionValue( argc, argv, idx ) );
 		} else if( !strcmp( argv[idx], "-noreflections" ) ) {
 		    no_reflections = true;
 		} else if( !strcmp( argv[idx], "-extremes" ) ) {
@@ -160,6 +210,36 @@ int main( int argc, char **argv )
 		    count = true;
 		} else if( !strcmp( argv[idx], "-neighbours" ) ) {
 		    neighs = true;
+		} else if( !strcmp( argv[idx], "-flush" ) ) {
+		    flush_output = true;
+		} else if( !strcmp( argv[idx], "-holeprop" ) ) {
+			hole_prop = true;
+		} else if( !strcmp( argv[idx], "-solver" ) ) {
+			backend = optionValue( argc, argv, idx );
+			if( !makeSATBackend( backend ) ) {
+				cerr << "Unknown SAT solver \"" << backend 
+					<< "\"; available:";
+				for( const auto& name : getSATBackendNames() ) {
+					cerr << " " << name;
+				}
+				cerr << endl;
+				exit( 0 );
+			}
+		} else if( !strcmp( argv[idx], "-engine" ) ) {
+			string engine = optionValue( argc, argv, idx );
+			if( engine == "dlx" ) {
+				use_dlx = true;
+			} else if( engine != "sat" ) {
+				cerr << "Unknown engine \"" << engine << "\"" << endl;
+				exit( 0 );
+			}
+		} else if( !strcmp( argv[idx], "-cubes" ) ) {
+			cube_threads = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-cube-depth" ) ) {
+			cube_depth = atoi( optionValue( argc, argv, idx ) );
+		} else if( !strcmp( argv[idx], "-dumpcnf" ) ) {
+			dump_dir = optionValue( argc, argv, idx );
+			filesystem::create_directories( dump_dir );
 		} else {
 			cerr << "Unrecognized parameter \"" << argv[idx] << "\""
 				<< endl;
@@ -167,6 +247,15 @@ int main( int argc, char **argv )
 		}
 	}
 
+	if( use_dlx && (heesch_level != 1) ) {
+		cerr << "The dlx engine only finds 1-coronas" << endl;
+		exit( 0 );
+	}
+	if( use_dlx && (cube_threads > 0) ) {
+		cerr << "The dlx engine runs on a single thread" << endl;
+		exit( 0 );
+	}
+
 	if( neighs ) {
 		FOR_EACH_IN_STREAM( cin, describeNeighbours );
 	} else if( count ) {
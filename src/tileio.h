@@ -79,6 +79,7 @@ public:
 		UNKNOWN,
 		HOLE,
 		INCONCLUSIVE,
+		TIMEOUT,
 
 		NONTILER,
 		ISOHEDRAL,
@@ -158,6 +159,20 @@ public:
 		}
 	}
 
+	// Ran out of time or conflicts before the Heesch number was settled.
+	// hc is the highest level known to have a hole-free corona.
+	void setTimedOut( size_t hc, const patch_t* hc_patch = nullptr )
+	{
+		record_type_ = TIMEOUT;
+		patches_.clear();
+
+		hc_ = hc;
+		hh_ = hc;
+		if( (hc > 0) && hc_patch ) {
+			patches_.push_back( *hc_patch );
+		}
+	}
+
 	void setNonTiler( 
 		size_t hc, const patch_t* hc_patch, size_t hh, const patch_t* hh_patch )
 	{
@@ -249,6 +264,9 @@ TileInfo<grid>::TileInfo( std::istream& is )
 		case '!':
 			record_type_ = INCONCLUSIVE;
 			break;
+		case '@':
+			record_type_ = TIMEOUT;
+			break;
 		case '~':
 			record_type_ = NONTILER;
 			break;
@@ -268,6 +286,9 @@ TileInfo<grid>::TileInfo( std::istream& is )
 	if( record_type_ == NONTILER ) {
 		hc_ = *i++;
 		hh_ = *i++;
+	} else if( record_type_ == TIMEOUT ) {
+		hc_ = *i++;
+		hh_ = hc_;
 	} else if( record_type_ == ISOHEDRAL || record_type_ == ANISOHEDRAL ) {
 		transitivity_ = *i++;
 	}
@@ -308,6 +329,9 @@ void TileInfo<grid>::write( std::ostream& os ) const
 		case INCONCLUSIVE:
 			os << '!';
 			break;
+		case TIMEOUT:
+			os << "@ " << hc_;
+			break;
 		case NONTILER:
 			os << "~ " << hc_ << ' ' << hh_;
 			break;
@@ -480,6 +480,9 @@ void Visualizer<grid>::drawText( double x, double y ) const
 		case info_t::INCONCLUSIVE:
 			out << "Analysis inconclusive";
 			break;
+		case info_t::TIMEOUT:
+			out << "Timed out, Hc >= " << tile_.getHeeschConnected();
+			break;
 		case info_t::NONTILER:
 			out << "Nontiler, Hc = " << tile_.getHeeschConnected() 
 				<< ", Hh = " << tile_.getHeeschHoles();
@@ -46,6 +46,7 @@ static bool shouldDraw( const TileInfo<grid>& tile )
 		case info_t::HOLE:
 			return draw_all || draw_holes;
 		case info_t::INCONCLUSIVE:
+		case info_t::TIMEOUT:
 			return draw_all || draw_inconclusive;
 		case info_t::NONTILER:
 			if( draw_all || draw_nontiler ) {
@@ -99,7 +100,8 @@ static bool drawPatch( const TileInfo<grid>& tile )
 
 	if( tile.getRecordType() == TileInfo<grid>::NONTILER ) {
 		viz.drawNontiler();
-	} else if( tile.getRecordType() == TileInfo<grid>::INCONCLUSIVE ) {
+	} else if( (tile.getRecordType() == TileInfo<grid>::INCONCLUSIVE)
+			|| (tile.getRecordType() == TileInfo<grid>::TIMEOUT) ) {
 		viz.drawInconclusive();
 	} else {
 		viz.drawShape( true );